@@ -0,0 +1,39 @@
+
+#include "AllocCounter.h"
+#include <stdlib.h>
+#include <new>
+
+std::atomic<uint64_t> AllocCounter::allocations(0);
+std::atomic<uint64_t> AllocCounter::frees(0);
+std::atomic<uint64_t> AllocCounter::bytes(0);
+
+#ifdef LANDER_COUNT_ALLOCS
+
+bool AllocCounter::enabled() { return true; }
+
+static void *countedAlloc(size_t n) {
+	AllocCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+	AllocCounter::bytes.fetch_add(n, std::memory_order_relaxed);
+	void *p = malloc(n > 0 ? n : 1);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+static void countedFree(void *p) {
+	if (p == NULL) return;
+	AllocCounter::frees.fetch_add(1, std::memory_order_relaxed);
+	free(p);
+}
+
+void *operator new(size_t n) { return countedAlloc(n); }
+void *operator new[](size_t n) { return countedAlloc(n); }
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
+
+#else
+
+bool AllocCounter::enabled() { return false; }
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+//  Counts heap allocations made through operator new / new[].
+//
+//  Only active when the program is built with LANDER_COUNT_ALLOCS,
+//  which makes AllocCounter.cpp replace the global operators; without
+//  it the counts stay 0 and enabled() is false.  To measure a frame or
+//  a benchmark, take a snapshot() before and subtract it from one after.
+//
+class AllocCounter {
+public:
+	class Snapshot {
+	public:
+		uint64_t allocations;
+		uint64_t frees;
+		uint64_t bytes;     // requested, not freed bytes
+		Snapshot operator-(const Snapshot &o) const {
+			return { allocations - o.allocations, frees - o.frees, bytes - o.bytes };
+		}
+	};
+
+	static bool enabled();
+	static Snapshot snapshot() {
+		return { allocations.load(std::memory_order_relaxed), frees.load(std::memory_order_relaxed),
+			bytes.load(std::memory_order_relaxed) };
+	}
+
+	static std::atomic<uint64_t> allocations;
+	static std::atomic<uint64_t> frees;
+	static std::atomic<uint64_t> bytes;
+};
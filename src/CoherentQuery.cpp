@@ -0,0 +1,239 @@
+
+#include "CoherentQuery.h"
+#include <cfloat>
+
+void CoherentQuery::setup(const Octree *o) {
+	octree = o;
+	stats.clear();
+	reset();
+}
+
+void CoherentQuery::reset() {
+	bWindow = false;
+	bAnswer = false;
+	bRayAnswer = false;
+	leaves.clear();
+	answer.clear();
+}
+
+static bool holdsBox(const Box &outer, const Box &box) {
+	return Vec4::allLessEqual3(Vec4::load3(outer.parameters[0]), Vec4::load3(box.parameters[0])) &&
+		Vec4::allLessEqual3(Vec4::load3(box.parameters[1]), Vec4::load3(outer.parameters[1]));
+}
+
+//  where the ray enters and leaves the box, with the test Box::intersect()
+//  uses for (0, 100000)
+//
+static bool crossing(const Box &b, const Ray &r, float &tIn, float &tOut) {
+	tIn = (b.parameters[r.sign[0]].x() - r.origin.x()) * r.inv_direction.x();
+	tOut = (b.parameters[1 - r.sign[0]].x() - r.origin.x()) * r.inv_direction.x();
+	for (int k = 1; k < 3; k++) {
+		float tmin = (b.parameters[r.sign[k]][k] - r.origin[k]) * r.inv_direction[k];
+		float tmax = (b.parameters[1 - r.sign[k]][k] - r.origin[k]) * r.inv_direction[k];
+		if (tIn > tmax || tmin > tOut) return false;
+		if (tmin > tIn) tIn = tmin;
+		if (tmax < tOut) tOut = tmax;
+	}
+	return tIn < 100000 && tOut > 0;
+}
+
+//  make sure the window holds the query volume, fetching a new one from
+//  the root if it doesn't; true if the old one did
+//
+bool CoherentQuery::fetch(const Box &volume) {
+	if (bWindow && holdsBox(window, volume)) return true;
+	Vector3 m(margin, margin, margin);
+	window = Box(volume.parameters[0] - m, volume.parameters[1] + m);
+	bWindow = true;
+	bAnswer = false;
+	bRayAnswer = false;
+	leaves.clear();
+	leavesIn(octree->root, window);
+	return false;
+}
+
+//  the nodes Octree::intersect(box, node, points) would take points from
+//
+void CoherentQuery::leavesIn(const TreeNode &node, const Box &box) {
+	stats.nodes++;
+	if (!node.box.overlap(box)) return;
+	octree->expand(node);
+	if (node.children.empty()) {
+		leaves.push_back(&node);
+		return;
+	}
+	for (const TreeNode &child : node.children) leavesIn(child, box);
+}
+
+//  Octree::intersect(box, node, points), counting the nodes it tests
+//
+void CoherentQuery::boxQuery(const TreeNode &node, const Box &box, vector<int> &pointsRtn) {
+	stats.nodes++;
+	if (!node.box.overlap(box)) return;
+	octree->expand(node);
+	if (node.children.empty()) {
+		pointsRtn.insert(pointsRtn.end(), node.points.begin(), node.points.end());
+		return;
+	}
+	for (const TreeNode &child : node.children) boxQuery(child, box, pointsRtn);
+}
+
+int CoherentQuery::intersect(const Box &box, vector<int> &pointsRtn) {
+	if (octree == NULL) return 0;
+	size_t count = pointsRtn.size();
+	stats.queries++;
+	if (!bEnabled) {
+		boxQuery(octree->root, box, pointsRtn);
+		return pointsRtn.size() - count;
+	}
+
+	if (fetch(box)) {
+		stats.hits++;
+
+		// no face crossed a leaf face: every overlap test comes out the same
+		//
+		bool bSame = bAnswer;
+		for (int f = 0; f < 6 && bSame; f++) {
+			float v = box.parameters[f / 3][f % 3];
+			bSame = f < 3 ? faceRange[f][0] < v && v <= faceRange[f][1] : faceRange[f][0] <= v && v < faceRange[f][1];
+		}
+		if (bSame) {
+			stats.reused++;
+			pointsRtn.insert(pointsRtn.end(), answer.begin(), answer.end());
+			return answer.size();
+		}
+	}
+
+	// Box::overlap() is leaf min <= box max and box min <= leaf max, so a
+	// box min face keeps its answers between the leaf max faces on either
+	// side of it, a box max face between the leaf min faces
+	//
+	for (int f = 0; f < 6; f++) {
+		faceRange[f][0] = -FLT_MAX;
+		faceRange[f][1] = FLT_MAX;
+	}
+	answer.clear();
+	for (const TreeNode *leaf : leaves) {
+		stats.nodes++;
+		if (leaf->box.overlap(box)) answer.insert(answer.end(), leaf->points.begin(), leaf->points.end());
+		for (int k = 0; k < 3; k++) {
+			float lo = box.parameters[0][k], hi = box.parameters[1][k];
+			float leafMax = leaf->box.parameters[1][k], leafMin = leaf->box.parameters[0][k];
+			if (leafMax < lo) faceRange[k][0] = MAX(faceRange[k][0], leafMax);
+			else faceRange[k][1] = MIN(faceRange[k][1], leafMax);
+			if (leafMin <= hi) faceRange[3 + k][0] = MAX(faceRange[3 + k][0], leafMin);
+			else faceRange[3 + k][1] = MIN(faceRange[3 + k][1], leafMin);
+		}
+	}
+	bAnswer = true;
+	pointsRtn.insert(pointsRtn.end(), answer.begin(), answer.end());
+	return answer.size();
+}
+
+bool CoherentQuery::intersectNearest(const Ray &ray, int &pointRtn, float &tRtn) {
+	pointRtn = -1;
+	if (octree == NULL) return false;
+	stats.queries++;
+	stats.nodes++;
+	float tIn, tOut;
+	if (!crossing(octree->root.box, ray, tIn, tOut)) return false;
+
+	float best = FLT_MAX;
+	if (!bEnabled) nearest(octree->root, ray, tIn, best, pointRtn);
+	else {
+		// every leaf the ray crosses is in the box around its part inside
+		// the terrain's box, so in the window's leaves
+		//
+		Vec4 a = Vec4::load3(ray.origin + ray.direction * MAX(tIn, 0));
+		Vec4 b = Vec4::load3(ray.origin + ray.direction * tOut);
+		Box segment(Vec4::min(a, b).toVector3(), Vec4::max(a, b).toVector3());
+		if (fetch(segment)) {
+			stats.hits++;
+
+			// an axis aligned ray whose origin crossed no leaf face crosses
+			// the same leaves in the same order
+			//
+			bool bSame = bRayAnswer && ray.direction == rayDirection;
+			for (int k = 0; k < 3 && bSame; k++) {
+				float lo = originRange[k][0], hi = originRange[k][1], v = ray.origin[k];
+				bSame = (lo < v && v < hi) || (lo == hi && v == lo);    // or still on the same face
+			}
+			if (bSame) {
+				stats.reused++;
+				if (rayLeaf == NULL) return false;
+				stats.nodes++;
+				float t0, t1;
+				crossing(rayLeaf->box, ray, t0, t1);
+				pointRtn = rayLeaf->points[0];
+				tRtn = MAX(t0, 0);
+				return true;
+			}
+		}
+
+		const TreeNode *found = NULL;
+		for (const TreeNode *leaf : leaves) {
+			stats.nodes++;
+			float t0, t1;
+			if (leaf->points.size() == 1 && crossing(leaf->box, ray, t0, t1) && MAX(t0, 0) < best) {
+				best = MAX(t0, 0);
+				pointRtn = leaf->points[0];
+				found = leaf;
+			}
+		}
+
+		int zeros = (ray.direction.x() == 0) + (ray.direction.y() == 0) + (ray.direction.z() == 0);
+		bRayAnswer = zeros == 2;
+		if (bRayAnswer) {
+			rayDirection = ray.direction;
+			rayLeaf = found;
+			for (int k = 0; k < 3; k++) {
+				originRange[k][0] = -FLT_MAX;
+				originRange[k][1] = FLT_MAX;
+				float o = ray.origin[k];
+				for (const TreeNode *leaf : leaves) {
+					for (int side = 0; side < 2; side++) {
+						float c = leaf->box.parameters[side][k];
+						if (c <= o) originRange[k][0] = MAX(originRange[k][0], c);
+						if (c >= o) originRange[k][1] = MIN(originRange[k][1], c);
+					}
+				}
+			}
+		}
+	}
+	tRtn = best;
+	return pointRtn >= 0;
+}
+
+//  nearest one point leaf under "node" (which the ray enters at tIn)
+//  closer than "best", children in the order the ray enters them
+//
+void CoherentQuery::nearest(const TreeNode &node, const Ray &ray, float tIn, float &best, int &pointRtn) {
+	if (node.points.size() == 1) {
+		float t = MAX(tIn, 0);
+		if (t < best) {
+			best = t;
+			pointRtn = node.points[0];
+		}
+		return;
+	}
+
+	octree->expand(node);
+	int order[8];
+	float entry[8];
+	int n = 0;
+	for (int i = 0; i < node.children.size() && n < 8; i++) {
+		float t0, t1;
+		stats.nodes++;
+		if (!crossing(node.children[i].box, ray, t0, t1) || MAX(t0, 0) >= best) continue;
+		int k = n++;
+		for (; k > 0 && entry[k - 1] > t0; k--) {
+			entry[k] = entry[k - 1];
+			order[k] = order[k - 1];
+		}
+		entry[k] = t0;
+		order[k] = i;
+	}
+	for (int k = 0; k < n && MAX(entry[k], 0) < best; k++) {
+		nearest(node.children[order[k]], ray, entry[k], best, pointRtn);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Octree.h"
+
+//  How often a CoherentQuery was answered without going to the octree,
+//  and how many octree nodes and cached leaves it tested to answer.
+//
+class CoherentStats {
+public:
+	long queries = 0;
+	long hits = 0;          // answered from the cached window
+	long reused = 0;        // of those, the last answer unchanged
+	long nodes = 0;
+
+	double hitRate() const { return queries > 0 ? (double)hits / queries : 0; }
+	double nodesPerQuery() const { return queries > 0 ? (double)nodes / queries : 0; }
+	void clear() { *this = CoherentStats(); }
+};
+
+//  Octree queries that start from what the last one found.
+//
+//  The lander moves centimeters per frame, so this frame's query volume
+//  is almost always close to last frame's.  On a miss the query volume
+//  is grown by "margin" into a window, and the leaves the window
+//  overlaps are fetched from the root once and kept.  While later query
+//  volumes stay inside the window, only those leaves can be in the
+//  answer, so only they are tested.  A box query also remembers how far
+//  each face of its box can move before it crosses a face of one of
+//  those leaves; until one does, the answer is the same as last time
+//  and no leaf is tested at all.
+//
+//  (Starting from the lowest octree node that holds the query volume
+//  doesn't work here: the lander sits on terrain that crosses the
+//  center planes of the root, so most of the time only the root holds
+//  its box.)
+//
+//  Box queries return exactly what Octree::intersect(box, root, points)
+//  returns, in the same order.  Ray queries return the nearest one point
+//  leaf the ray crosses, searching the leaves of a window around the
+//  part of the ray inside the terrain's box.  An axis aligned ray (the
+//  altitude radar) keeps its answer the same way a box does, while its
+//  origin crosses no leaf face.
+//
+//  The window is the caller's own state: each thread (or lander) uses
+//  its own CoherentQuery, and any number of them can share one octree.
+//
+class CoherentQuery {
+public:
+	CoherentQuery() { octree = NULL; bEnabled = true; margin = 0.5; }
+	void setup(const Octree *octree);
+	void reset();           // forget the window, after the lander jumps
+
+	// points of every leaf the box overlaps; returns the number added
+	//
+	int intersect(const Box &box, vector<int> &pointsRtn);
+
+	// point of the nearest one point leaf the ray crosses (t >= 0), and
+	// where the ray enters that leaf
+	//
+	bool intersectNearest(const Ray &ray, int &pointRtn, float &tRtn);
+
+	const Octree *octree;
+	bool bEnabled;          // false: every query from the root, for comparison
+	float margin;           // how far the window reaches past the query volume
+	CoherentStats stats;
+
+private:
+	bool fetch(const Box &volume);
+	void leavesIn(const TreeNode &node, const Box &box);
+	void boxQuery(const TreeNode &node, const Box &box, vector<int> &pointsRtn);
+	void nearest(const TreeNode &node, const Ray &ray, float tIn, float &best, int &pointRtn);
+
+	bool bWindow;
+	Box window;
+	vector<const TreeNode *> leaves;    // leaves the window overlaps, tree order
+
+	// last box query: its answer, and the range each face of the box can
+	// move in without changing it (lower, upper per face, min x y z then
+	// max x y z)
+	//
+	bool bAnswer;
+	vector<int> answer;
+	float faceRange[6][2];
+
+	// last ray query: its direction and leaf, and the range each origin
+	// coordinate can move in without changing it (a single value when
+	// it is on a leaf face)
+	//
+	bool bRayAnswer;
+	Vector3 rayDirection;
+	const TreeNode *rayLeaf;            // NULL if it crossed none
+	float originRange[3][2];
+};
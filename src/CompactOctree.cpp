@@ -0,0 +1,577 @@
+
+#include "CompactOctree.h"
+#include <cfloat>
+
+//  number of octants set in an 8 bit child mask
+//
+static inline int childCount(int mask) {
+	mask = mask - ((mask >> 1) & 0x55);
+	mask = (mask & 0x33) + ((mask >> 2) & 0x33);
+	return (mask + (mask >> 4)) & 0x0f;
+}
+
+//  same arithmetic as Octree::subDivideBox8(): octants 0-3 go around the
+//  bottom (x, then z, then back in x), 4-7 are the same one step up in y.
+//  Each corner is min or center, plus step[octant] * d, plus back[octant]
+//  * d (octant 3 steps out in x and back again, as subDivideBox8() does);
+//  adding 0 * d leaves a coordinate exactly as it was.
+//
+static const Vec4 step[8] = {
+	Vec4(0, 0, 0), Vec4(1, 0, 0), Vec4(1, 0, 1), Vec4(1, 0, 1),
+	Vec4(0, 1, 0), Vec4(1, 1, 0), Vec4(1, 1, 1), Vec4(1, 1, 1)
+};
+static const Vec4 back[8] = {
+	Vec4(0, 0, 0), Vec4(0, 0, 0), Vec4(0, 0, 0), Vec4(-1, 0, 0),
+	Vec4(0, 0, 0), Vec4(0, 0, 0), Vec4(0, 0, 0), Vec4(-1, 0, 0)
+};
+
+void CompactOctree::childCell(const Vec4 &min, const Vec4 &max, int octant, Vec4 &cmin, Vec4 &cmax) {
+	Vec4 d = (max - min) * 0.5f;
+	Vec4 center = d + min;
+	Vec4 out = d * step[octant];
+	Vec4 in = d * back[octant];
+	cmin = (min + out) + in;
+	cmax = (center + out) + in;
+}
+
+void CompactOctree::build(const Octree &tree, BoundsMode mode) {
+	this->mode = mode;
+	rootBox = tree.root.box;
+	nodes.assign(1, CompactNode());
+	points.clear();
+	bounds8.clear();
+	bounds16.clear();
+	add(tree, tree.root, 0);
+
+	if (mode != CellBounds) {
+		if (mode == Quantized8) bounds8.assign(nodes.size() * 6, 0);
+		else bounds16.assign(nodes.size() * 6, 0);
+		Vec4 lo, hi;
+		fillBounds(tree.mesh, 0, Vec4::load3(rootBox.parameters[0]), Vec4::load3(rootBox.parameters[1]), lo, hi);
+	}
+}
+
+//  copy "node" into nodes[index], its children after everything so far
+//
+void CompactOctree::add(const Octree &tree, const TreeNode &node, uint32_t index) {
+	int count = MIN(node.points.size(), (size_t)0xffffff);
+	tree.expand(node);      // a lazy tree is built out completely
+	if (node.children.empty()) {
+		nodes[index].first = points.size();
+		nodes[index].info = count << 8;
+		points.insert(points.end(), node.points.begin(), node.points.end());
+		return;
+	}
+
+	// the octant of each child; the tree adds them in octant order
+	//
+	Vec4 min = Vec4::load3(node.box.parameters[0]);
+	Vec4 max = Vec4::load3(node.box.parameters[1]);
+	int mask = 0;
+	int octant = 0;
+	for (const TreeNode &child : node.children) {
+		Vec4 cmin, cmax;
+		for (; octant < 8; octant++) {
+			childCell(min, max, octant, cmin, cmax);
+			if (cmin.toVector3() == child.box.parameters[0] && cmax.toVector3() == child.box.parameters[1]) break;
+		}
+		assert(octant < 8);     // not a cell of this node
+		mask |= 1 << octant++;
+	}
+
+	uint32_t first = nodes.size();
+	nodes.resize(first + node.children.size());
+	nodes[index].first = first;
+	nodes[index].info = mask | (count << 8);
+	for (int k = 0; k < node.children.size(); k++) {
+		add(tree, node.children[k], first + k);
+	}
+}
+
+//  quantized bounds are min + q * (size / levels), here and in queries
+//
+static inline Vec4 dequantize(const Vec4 &min, const Vec4 &size, float qx, float qy, float qz, float levels) {
+	return min + Vec4(qx, qy, qz) * (size * (1 / levels));
+}
+
+//  bounds of the points under nodes[index] (lo, hi), then stored quantized
+//
+void CompactOctree::fillBounds(const ofMesh &mesh, int index, const Vec4 &cmin, const Vec4 &cmax,
+	Vec4 &lo, Vec4 &hi) {
+
+	const CompactNode &n = nodes[index];
+	lo = Vec4(FLT_MAX, FLT_MAX, FLT_MAX);
+	hi = Vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	if (n.isLeaf()) {
+		const glm::vec3 *verts = mesh.getVerticesPointer();
+		for (int i = n.first; i < n.first + n.count(); i++) {
+			Vec4 v = Vec4::of(verts[points[i]]);
+			lo = Vec4::min(lo, v);
+			hi = Vec4::max(hi, v);
+		}
+	}
+	else {
+		int child = n.first;
+		for (int o = 0; o < 8; o++) {
+			if (!(n.childMask() & (1 << o))) continue;
+			Vec4 ccmin, ccmax, clo, chi;
+			childCell(cmin, cmax, o, ccmin, ccmax);
+			fillBounds(mesh, child++, ccmin, ccmax, clo, chi);
+			lo = Vec4::min(lo, clo);
+			hi = Vec4::max(hi, chi);
+		}
+	}
+	quantize(index, cmin, cmax, lo, hi);
+}
+
+//  round outward, then step once more where float error still cut a
+//  point off, checked with the same arithmetic the queries use
+//
+void CompactOctree::quantize(int index, const Vec4 &cmin, const Vec4 &cmax, const Vec4 &lo, const Vec4 &hi) {
+	int levels = mode == Quantized8 ? 255 : 65535;
+	float min[3], size[3], l[3], h[3];
+	cmin.store3(min);
+	(cmax - cmin).store3(size);
+	lo.store3(l);
+	hi.store3(h);
+
+	int a[3], b[3];
+	for (int k = 0; k < 3; k++) {
+		a[k] = 0;
+		b[k] = levels;
+		if (size[k] > 0 && l[k] <= h[k]) {
+			a[k] = ofClamp(floor((l[k] - min[k]) / size[k] * levels), 0, levels);
+			b[k] = ofClamp(ceil((h[k] - min[k]) / size[k] * levels), 0, levels);
+		}
+	}
+	for (int tries = 0; tries < 2; tries++) {
+		float dl[3], dh[3];
+		dequantize(cmin, cmax - cmin, a[0], a[1], a[2], levels).store3(dl);
+		dequantize(cmin, cmax - cmin, b[0], b[1], b[2], levels).store3(dh);
+		for (int k = 0; k < 3; k++) {
+			if (a[k] > 0 && dl[k] > l[k]) a[k]--;
+			if (b[k] < levels && dh[k] < h[k]) b[k]++;
+		}
+	}
+
+	for (int k = 0; k < 3; k++) {
+		if (mode == Quantized8) {
+			bounds8[index * 6 + k] = a[k];
+			bounds8[index * 6 + 3 + k] = b[k];
+		}
+		else {
+			bounds16[index * 6 + k] = a[k];
+			bounds16[index * 6 + 3 + k] = b[k];
+		}
+	}
+}
+
+void CompactOctree::tightBounds(int index, const Vec4 &cmin, const Vec4 &cmax, Vec4 &lo, Vec4 &hi) const {
+	Vec4 size = cmax - cmin;
+	if (mode == Quantized8) {
+		const uint8_t *q = &bounds8[index * 6];
+		lo = dequantize(cmin, size, q[0], q[1], q[2], 255);
+		hi = dequantize(cmin, size, q[3], q[4], q[5], 255);
+	}
+	else {
+		const uint16_t *q = &bounds16[index * 6];
+		lo = dequantize(cmin, size, q[0], q[1], q[2], 65535);
+		hi = dequantize(cmin, size, q[3], q[4], q[5], 65535);
+	}
+}
+
+//  a node waiting to be visited, with its cell
+//
+class CompactVisit {
+public:
+	Vec4 min, max;
+	int index;
+};
+
+const void *CompactOctree::boundsOf(int index) const {
+	if (mode == Quantized8) return &bounds8[index * 6];
+	if (mode == Quantized16) return &bounds16[index * 6];
+	return NULL;
+}
+
+void CompactOctree::prefetchChildren(const CompactNode &n) const {
+#if defined(LANDER_SSE)
+	_mm_prefetch((const char *)&nodes[n.first], _MM_HINT_T0);
+	if (mode != CellBounds) _mm_prefetch((const char *)boundsOf(n.first), _MM_HINT_T0);
+#elif defined(__GNUC__)
+	__builtin_prefetch(&nodes[n.first]);
+	if (mode != CellBounds) __builtin_prefetch(boundsOf(n.first));
+#endif
+}
+
+//  depth first without recursion.  Children are tested last to first
+//  and pushed as they pass, so the first octant is popped first and
+//  leaves come out in the tree's order.
+//
+template <class Read>
+int CompactOctree::boxQuery(const Box &box, vector<int> &pointsRtn, Read &read) const {
+	if (nodes.empty()) return 0;
+	size_t count = pointsRtn.size();
+	Vec4 qmin = Vec4::load3(box.parameters[0]);
+	Vec4 qmax = Vec4::load3(box.parameters[1]);
+
+	// a node's bounds for the test: its cell, or the tight box in it
+	//
+	auto overlaps = [&](int index, const Vec4 &cmin, const Vec4 &cmax) {
+		if (mode == CellBounds) return Vec4::allLessEqual3(qmin, cmax) && Vec4::allLessEqual3(cmin, qmax);
+		Vec4 lo, hi;
+		read(boundsOf(index));
+		tightBounds(index, cmin, cmax, lo, hi);
+		return Vec4::allLessEqual3(qmin, hi) && Vec4::allLessEqual3(lo, qmax);
+	};
+
+	CompactVisit stack[8 * 32];
+	int top = 0;
+	CompactVisit root = { Vec4::load3(rootBox.parameters[0]), Vec4::load3(rootBox.parameters[1]), 0 };
+	if (overlaps(0, root.min, root.max)) stack[top++] = root;
+
+	while (top > 0) {
+		CompactVisit v = stack[--top];
+		read(&nodes[v.index]);
+		const CompactNode &n = nodes[v.index];
+		if (n.isLeaf()) {
+			pointsRtn.insert(pointsRtn.end(), points.begin() + n.first, points.begin() + n.first + n.count());
+			continue;
+		}
+		if (prefetch) prefetchChildren(n);
+
+		// childCell() with d and center worked out once for all eight
+		//
+		Vec4 d = (v.max - v.min) * 0.5f;
+		Vec4 center = d + v.min;
+		int mask = n.childMask();
+		int child = n.first + childCount(mask);
+		for (int o = 7; o >= 0; o--) {
+			if (!(mask & (1 << o))) continue;
+			child--;
+			Vec4 out = d * step[o];
+			Vec4 in = d * back[o];
+			CompactVisit &c = stack[top];
+			c.min = (v.min + out) + in;
+			c.max = (center + out) + in;
+			c.index = child;
+			if (overlaps(child, c.min, c.max)) top++;
+		}
+	}
+	return pointsRtn.size() - count;
+}
+
+template <class Read>
+void CompactOctree::rayQuery(int index, const Vec4 &cmin, const Vec4 &cmax, const Ray &ray, int &pointRtn,
+	Read &read) const {
+
+	Box cell(cmin.toVector3(), cmax.toVector3());
+	if (!cell.intersect(ray, 0, 100000)) return;
+
+	read(&nodes[index]);
+	const CompactNode &n = nodes[index];
+	if (n.isLeaf()) {
+		if (n.count() == 1) pointRtn = points[n.first];
+		return;
+	}
+	if (prefetch) prefetchChildren(n);
+	int child = n.first;
+	for (int o = 0; o < 8; o++) {
+		if (!(n.childMask() & (1 << o))) continue;
+		Vec4 ccmin, ccmax;
+		childCell(cmin, cmax, o, ccmin, ccmax);
+		rayQuery(child++, ccmin, ccmax, ray, pointRtn, read);
+	}
+}
+
+//  the queries, reading nothing extra
+//
+static inline void noRead(const void *) {}
+
+int CompactOctree::intersect(const Box &box, vector<int> &pointsRtn) const {
+	return boxQuery(box, pointsRtn, noRead);
+}
+
+bool CompactOctree::intersect(const Ray &ray, int &pointRtn) const {
+	if (nodes.empty()) return false;
+	pointRtn = -1;
+	rayQuery(0, Vec4::load3(rootBox.parameters[0]), Vec4::load3(rootBox.parameters[1]), ray, pointRtn, noRead);
+	return pointRtn >= 0;
+}
+
+void CompactOctree::trace(const Box &box, vector<const void *> &reads) const {
+	vector<int> points;
+	auto read = [&](const void *p) { reads.push_back(p); };
+	boxQuery(box, points, read);
+}
+
+void CompactOctree::trace(const Ray &ray, vector<const void *> &reads) const {
+	if (nodes.empty()) return;
+	int point = -1;
+	auto read = [&](const void *p) { reads.push_back(p); };
+	rayQuery(0, Vec4::load3(rootBox.parameters[0]), Vec4::load3(rootBox.parameters[1]), ray, point, read);
+}
+
+//  octant <-> position bits (x 1, y 2, z 4) in subDivideBox8() order
+//
+static const int octantBits[8] = { 0, 1, 5, 4, 2, 3, 7, 6 };
+static const int bitsOctant[8] = { 0, 1, 4, 5, 3, 2, 7, 6 };
+
+const uint32_t CompactOctree::noRope;
+
+uint32_t CompactOctree::childAt(const CompactNode &n, int octant) const {
+	return n.first + childCount(n.childMask() & ((1 << octant) - 1));
+}
+
+void CompactOctree::buildRopes() {
+	cells.assign(nodes.size(), rootBox);
+	ropes.assign(nodes.size() * 6, noRope);
+	if (nodes.empty()) return;
+	vector<uint8_t> depth(nodes.size(), 0);
+	ropeChildren(0, depth);
+}
+
+//  cells and ropes of the children of nodes[index], then theirs.  Faces
+//  inside the node lead to the sibling across them, or to the node when
+//  that octant is empty.  Outside faces take the node's rope, moved down
+//  to the matching child of the neighbour when it is as deep as the node.
+//
+void CompactOctree::ropeChildren(uint32_t index, vector<uint8_t> &depth) {
+	const CompactNode &n = nodes[index];
+	if (n.isLeaf()) return;
+	Vec4 min = Vec4::load3(cells[index].parameters[0]);
+	Vec4 max = Vec4::load3(cells[index].parameters[1]);
+
+	for (int o = 0; o < 8; o++) {
+		if (!(n.childMask() & (1 << o))) continue;
+		uint32_t child = childAt(n, o);
+		Vec4 cmin, cmax;
+		childCell(min, max, o, cmin, cmax);
+		cells[child] = Box(cmin.toVector3(), cmax.toVector3());
+		depth[child] = depth[index] + 1;
+
+		int bits = octantBits[o];
+		for (int axis = 0; axis < 3; axis++) {
+			int across = bitsOctant[bits ^ (1 << axis)];
+			int inside = (bits >> axis) & 1 ? 0 : 1;      // the side facing the sibling
+			for (int side = 0; side < 2; side++) {
+				uint32_t rope;
+				if (side == inside) {
+					rope = n.childMask() & (1 << across) ? childAt(n, across) : index;
+				}
+				else {
+					rope = ropes[index * 6 + axis * 2 + side];
+					if (rope != noRope && depth[rope] == depth[index] && (nodes[rope].childMask() & (1 << across))) {
+						rope = childAt(nodes[rope], across);
+					}
+				}
+				ropes[child * 6 + axis * 2 + side] = rope;
+			}
+		}
+	}
+	for (int i = 0; i < childCount(n.childMask()); i++) ropeChildren(n.first + i, depth);
+}
+
+//  parameter range [tIn, tOut] of the ray's line inside the box, and the
+//  axis it leaves through (-1 if it runs parallel to all three)
+//
+static bool slab(const Box &box, const Ray &ray, float &tIn, float &tOut, int &exitAxis) {
+	tIn = -FLT_MAX;
+	tOut = FLT_MAX;
+	exitAxis = -1;
+	for (int k = 0; k < 3; k++) {
+		if (ray.direction[k] == 0) {
+			if (ray.origin[k] < box.parameters[0][k] || ray.origin[k] > box.parameters[1][k]) return false;
+			continue;
+		}
+		float tNear = (box.parameters[ray.sign[k]][k] - ray.origin[k]) * ray.inv_direction[k];
+		float tFar = (box.parameters[1 - ray.sign[k]][k] - ray.origin[k]) * ray.inv_direction[k];
+		tIn = MAX(tIn, tNear);
+		if (tFar < tOut) {
+			tOut = tFar;
+			exitAxis = k;
+		}
+	}
+	return tIn <= tOut;
+}
+
+//  From nodes[index] (cell "cell") down to the leaf or empty octant that
+//  holds "point", taking the far side of "plane" along "axis" (axis -1:
+//  none) so a cell the ray just left isn't found again.  Returns true
+//  for an empty octant, leaving index at the node it's in.
+//
+bool CompactOctree::locate(uint32_t &index, Box &cell, const Ray &ray, const Vector3 &point, int axis,
+	float plane) const {
+
+	while (true) {
+		const CompactNode &n = nodes[index];
+		if (n.isLeaf()) return false;
+		Vec4 min = Vec4::load3(cell.parameters[0]);
+		Vec4 max = Vec4::load3(cell.parameters[1]);
+		float center[3], size[3];
+		((max - min) * 0.5f + min).store3(center);
+		(max - min).store3(size);
+
+		int bits = 0;
+		for (int k = 0; k < 3; k++) {
+			float v = k == axis ? plane : point[k];
+			float tolerance = k == axis ? size[k] * 1e-4f : 0;
+			bool up = ray.sign[k] ? v > center[k] + tolerance : v >= center[k] - tolerance;
+			if (up) bits |= 1 << k;
+		}
+		int octant = bitsOctant[bits];
+		if (!(n.childMask() & (1 << octant))) {
+			Vec4 cmin, cmax;
+			childCell(min, max, octant, cmin, cmax);
+			cell = Box(cmin.toVector3(), cmax.toVector3());
+			return true;
+		}
+		index = childAt(n, octant);
+		cell = cells[index];
+	}
+}
+
+//  Enter at the root, then leave each cell through its exit face and
+//  follow that face's rope, locating the next cell from there.  An empty
+//  octant has no ropes of its own: the walk goes on from its node, or
+//  through the node's rope when the exit face is on the node's face too.
+//
+bool CompactOctree::intersectNearest(const Ray &ray, int &pointRtn, float t0, float t1) const {
+	pointRtn = -1;
+	if (ropes.empty()) return false;
+	float tIn, tOut;
+	int axis;
+	if (!slab(rootBox, ray, tIn, tOut, axis) || tOut < t0 || tIn > t1) return false;
+
+	float t = MAX(tIn, t0);
+	uint32_t index = 0;
+	Box cell = rootBox;
+	bool empty = locate(index, cell, ray, ray.origin + ray.direction * t, -1, 0);
+	for (size_t steps = 0; steps <= nodes.size(); steps++) {
+		if (!empty && nodes[index].count() == 1) {
+			pointRtn = points[nodes[index].first];
+			return true;
+		}
+		slab(cell, ray, tIn, tOut, axis);
+		if (axis < 0 || tOut >= t1) return false;
+
+		int side = ray.sign[axis] ? 0 : 1;
+		float plane = cell.parameters[side][axis];
+		const Box &owner = cells[index];
+		float tolerance = (owner.parameters[1][axis] - owner.parameters[0][axis]) * 1e-4f;
+		uint32_t next = index;
+		if (!empty || fabs(owner.parameters[side][axis] - plane) <= tolerance) next = ropes[index * 6 + axis * 2 + side];
+		if (next == noRope) return false;
+
+		t = MAX(t, tOut);
+		index = next;
+		cell = cells[next];
+		empty = locate(index, cell, ray, ray.origin + ray.direction * t, axis, plane);
+	}
+	return false;
+}
+
+//  node and bounds arrays moved to the new indices
+//
+template <class T>
+static void moveNodes(vector<T> &v, int stride, const vector<uint32_t> &newIndex) {
+	if (v.empty()) return;
+	vector<T> moved(v.size());
+	for (size_t i = 0; i < newIndex.size(); i++) {
+		copy(v.begin() + i * stride, v.begin() + (i + 1) * stride, moved.begin() + newIndex[i] * stride);
+	}
+	v.swap(moved);
+}
+
+//  Each inner node's children have to stay together, so an order is a
+//  list of inner nodes: their child blocks are placed one after another
+//  behind the root in that order.
+//
+void CompactOctree::reorder(NodeOrder order) {
+	this->order = order;
+	if (nodes.empty()) return;
+
+	vector<uint32_t> parents;
+	if (order == DepthFirst) depthFirst(0, parents);
+	else if (order == VanEmdeBoas) vanEmdeBoas(0, innerHeight(0), parents);
+	else {
+		if (!nodes[0].isLeaf()) parents.push_back(0);
+		for (size_t k = 0; k < parents.size(); k++) {
+			const CompactNode &n = nodes[parents[k]];
+			for (int i = 0; i < childCount(n.childMask()); i++) {
+				if (!nodes[n.first + i].isLeaf()) parents.push_back(n.first + i);
+			}
+		}
+	}
+
+	vector<uint32_t> newIndex(nodes.size());
+	newIndex[0] = 0;
+	uint32_t next = 1;
+	for (uint32_t p : parents) {
+		const CompactNode &n = nodes[p];
+		for (int i = 0; i < childCount(n.childMask()); i++) newIndex[n.first + i] = next++;
+	}
+	for (CompactNode &n : nodes) {
+		if (!n.isLeaf()) n.first = newIndex[n.first];
+	}
+	moveNodes(nodes, 1, newIndex);
+	moveNodes(bounds8, 6, newIndex);
+	moveNodes(bounds16, 6, newIndex);
+	for (uint32_t &rope : ropes) {
+		if (rope != noRope) rope = newIndex[rope];
+	}
+	moveNodes(ropes, 6, newIndex);
+	moveNodes(cells, 1, newIndex);
+}
+
+//  levels of inner nodes from nodes[index] down, 0 for a leaf
+//
+int CompactOctree::innerHeight(uint32_t index) const {
+	const CompactNode &n = nodes[index];
+	int height = 0;
+	for (int i = 0; i < childCount(n.childMask()); i++) height = MAX(height, innerHeight(n.first + i));
+	return n.isLeaf() ? 0 : height + 1;
+}
+
+void CompactOctree::depthFirst(uint32_t index, vector<uint32_t> &parents) const {
+	const CompactNode &n = nodes[index];
+	if (n.isLeaf()) return;
+	parents.push_back(index);
+	for (int i = 0; i < childCount(n.childMask()); i++) depthFirst(n.first + i, parents);
+}
+
+//  the inner nodes in the top "height" levels under nodes[index]: the
+//  top half of those levels first, then each subtree hanging below it
+//
+void CompactOctree::vanEmdeBoas(uint32_t index, int height, vector<uint32_t> &parents) const {
+	if (height <= 0 || nodes[index].isLeaf()) return;
+	if (height == 1) {
+		parents.push_back(index);
+		return;
+	}
+	int top = height / 2;
+	vanEmdeBoas(index, top, parents);
+	vector<uint32_t> bottom;
+	below(index, top, bottom);
+	for (uint32_t b : bottom) vanEmdeBoas(b, height - top, parents);
+}
+
+//  nodes "depth" levels under nodes[index], left to right
+//
+void CompactOctree::below(uint32_t index, int depth, vector<uint32_t> &nodesRtn) const {
+	if (depth == 0) {
+		nodesRtn.push_back(index);
+		return;
+	}
+	const CompactNode &n = nodes[index];
+	for (int i = 0; i < childCount(n.childMask()); i++) below(n.first + i, depth - 1, nodesRtn);
+}
+
+size_t CompactOctree::boundsBytes() const {
+	return bounds8.size() * sizeof(uint8_t) + bounds16.size() * sizeof(uint16_t);
+}
+
+size_t CompactOctree::bytes() const {
+	return nodes.size() * sizeof(CompactNode) + points.size() * sizeof(int) + boundsBytes() +
+		cells.size() * sizeof(Box) + ropes.size() * sizeof(uint32_t);
+}
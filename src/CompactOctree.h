@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Octree.h"
+
+//  One node of a CompactOctree, 8 bytes.
+//
+class CompactNode {
+public:
+	uint32_t first;     // inner node: index of its first child, leaf: of its first point
+	uint32_t info;      // octants that have a child in the low 8 bits (0 = leaf), point count above
+
+	bool isLeaf() const { return (info & 0xff) == 0; }
+	int childMask() const { return info & 0xff; }
+	int count() const { return info >> 8; }
+};
+
+//  Octree flattened into arrays for fast queries.
+//
+//  A TreeNode keeps a Box, a point list and a child vector, 72 bytes
+//  plus two heap blocks, and every inner node repeats the points of its
+//  children.  Here a node is 8 bytes, the children of a node sit next to
+//  each other, and only leaves keep points.  A node's cell isn't stored:
+//  it follows from the root box and the octants on the way down, worked
+//  out with the same arithmetic as Octree::subDivideBox8(), so queries
+//  give exactly the tree's results.
+//
+//  build() leaves the node blocks in depth first order; reorder() can
+//  lay them out breadth first or van Emde Boas (a subtree of a few
+//  levels, then each subtree below it, recursively) instead, and
+//  setting prefetch fetches a node's child block while its children's
+//  cells are worked out.  Query results don't depend on either.
+//
+//  buildRopes() adds each node's cell and its six face neighbours
+//  ("ropes": the deepest node whose cell covers the region across that
+//  face).  intersectNearest() then finds where a ray enters the tree and
+//  walks from leaf to leaf along the ropes, with no stack and no descent
+//  from the root, stopping at the first leaf it hits.
+//
+//  Optionally every node also gets the tight bounds of its points,
+//  quantized to 8 or 16 bits per coordinate inside its cell and rounded
+//  outward, so the decoded box always contains the points.  Box queries
+//  then test those instead of the cells and skip empty space; they still
+//  return every point inside the query box.  Ray queries always use the
+//  cells, the way the tree does.
+//
+class CompactOctree {
+public:
+	enum BoundsMode { CellBounds, Quantized8, Quantized16 };
+	enum NodeOrder { DepthFirst, BreadthFirst, VanEmdeBoas };
+
+	CompactOctree() { mode = CellBounds; order = DepthFirst; prefetch = false; }
+	void build(const Octree &tree, BoundsMode mode = CellBounds);
+
+	// move the child blocks into "order" and re-index the nodes
+	//
+	void reorder(NodeOrder order);
+
+	// points of every leaf whose bounds overlap the box, like
+	// Octree::intersect(box, root, points); returns the number added
+	//
+	int intersect(const Box &box, vector<int> &pointsRtn) const;
+
+	// point of the last one point leaf whose cell the ray crosses, like
+	// Octree::intersect(ray, root, node), but false if there isn't one
+	//
+	bool intersect(const Ray &ray, int &pointRtn) const;
+
+	// cells and face neighbours of all nodes for intersectNearest(),
+	// 48 bytes a node
+	//
+	void buildRopes();
+
+	// point of the nearest one point leaf whose cell the ray crosses
+	// between t0 and t1, found along the ropes; false if there isn't one
+	//
+	bool intersectNearest(const Ray &ray, int &pointRtn, float t0 = 0, float t1 = 100000) const;
+
+	// addresses of the node and bounds data a query reads, in the order
+	// it reads them, for cache studies (see the bench "order" group)
+	//
+	void trace(const Box &box, vector<const void *> &reads) const;
+	void trace(const Ray &ray, vector<const void *> &reads) const;
+
+	size_t bytes() const;           // nodes, bounds, point lists and ropes
+	size_t boundsBytes() const;     // the quantized bounds alone
+
+	vector<CompactNode> nodes;      // root first, each node's children together
+	vector<int> points;             // leaf point lists back to back
+	vector<uint8_t> bounds8;        // Quantized8: min x y z, max x y z per node
+	vector<uint16_t> bounds16;      // Quantized16: the same at 16 bits
+	Box rootBox;
+	BoundsMode mode;
+	NodeOrder order;
+	bool prefetch;                  // prefetch child blocks in queries
+	vector<Box> cells;              // after buildRopes(): cell of each node
+	vector<uint32_t> ropes;         // -x +x -y +y -z +z neighbour of each node, noRope outside the root
+	static const uint32_t noRope = 0xffffffff;
+
+	// cell of child "octant" (subDivideBox8() order) of the cell min - max
+	//
+	static void childCell(const Vec4 &min, const Vec4 &max, int octant, Vec4 &cmin, Vec4 &cmax);
+
+private:
+	void add(const Octree &tree, const TreeNode &node, uint32_t index);
+	void fillBounds(const ofMesh &mesh, int index, const Vec4 &cmin, const Vec4 &cmax, Vec4 &lo, Vec4 &hi);
+	void quantize(int index, const Vec4 &cmin, const Vec4 &cmax, const Vec4 &lo, const Vec4 &hi);
+	void tightBounds(int index, const Vec4 &cmin, const Vec4 &cmax, Vec4 &lo, Vec4 &hi) const;
+	const void *boundsOf(int index) const;
+	void prefetchChildren(const CompactNode &n) const;
+
+	// the queries, calling read(address) for each node and bounds read
+	//
+	template <class Read> int boxQuery(const Box &box, vector<int> &pointsRtn, Read &read) const;
+	template <class Read> void rayQuery(int index, const Vec4 &cmin, const Vec4 &cmax, const Ray &ray,
+		int &pointRtn, Read &read) const;
+
+	void ropeChildren(uint32_t index, vector<uint8_t> &depth);
+	uint32_t childAt(const CompactNode &n, int octant) const;
+	bool locate(uint32_t &index, Box &cell, const Ray &ray, const Vector3 &point, int axis, float plane) const;
+
+	int innerHeight(uint32_t index) const;
+	void depthFirst(uint32_t index, vector<uint32_t> &parents) const;
+	void vanEmdeBoas(uint32_t index, int height, vector<uint32_t> &parents) const;
+	void below(uint32_t index, int depth, vector<uint32_t> &nodesRtn) const;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+//  Fixed step simulation clock.
+//
+//  The frame loop feeds in real elapsed time and gets back how many
+//  physics steps of exactly dt() seconds to run, so the simulation
+//  behaves the same at any frame rate.  Left over time carries to the
+//  next frame and alpha() tells the renderer how far to interpolate
+//  between the last two physics states.
+//
+//  If the machine can't keep up, at most maxSubsteps steps are run per
+//  frame and the rest of the backlog is dropped (the simulation slows
+//  down instead of spiralling further behind).
+//
+class FixedTimestep {
+public:
+	FixedTimestep(float hz = 120, int maxSubsteps = 8) {
+		setRate(hz);
+		this->maxSubsteps = maxSubsteps;
+		accumulator = 0;
+	}
+	void setRate(float hz) { rate = hz; step = 1.0 / hz; }
+	void setMaxSubsteps(int n) { maxSubsteps = n; }
+
+	// add "frameTime" seconds of real time, return number of steps to run
+	//
+	int advance(double frameTime) {
+		if (frameTime < 0) frameTime = 0;
+		accumulator += frameTime;
+		int steps = (int)(accumulator / step);
+		if (steps > maxSubsteps) {
+			steps = maxSubsteps;
+			accumulator = 0;
+		}
+		else accumulator -= steps * step;
+		return steps;
+	}
+
+	float dt() const { return (float)step; }
+	float alpha() const { return (float)(accumulator / step); }
+
+	float rate;         // steps per sec
+	int maxSubsteps;    // clamp per frame
+private:
+	double step;
+	double accumulator;
+};
@@ -0,0 +1,302 @@
+
+#include "InputLog.h"
+#include <fstream>
+
+static const char magic[4] = { 'L', 'L', 'I', 'N' };
+static const uint32_t version = 1;
+
+//  raw little endian fields and varints in a byte buffer
+//
+template <class T>
+static void put(vector<uint8_t> &buf, const T &v) {
+	const uint8_t *p = (const uint8_t *)&v;
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template <class T>
+static bool get(const vector<uint8_t> &buf, size_t &pos, T &v) {
+	if (pos + sizeof(T) > buf.size()) return false;
+	memcpy(&v, &buf[pos], sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+static void putVarint(vector<uint8_t> &buf, uint64_t v) {
+	while (v >= 0x80) {
+		buf.push_back((uint8_t)(v | 0x80));
+		v >>= 7;
+	}
+	buf.push_back((uint8_t)v);
+}
+
+static bool getVarint(const vector<uint8_t> &buf, size_t &pos, uint64_t &v) {
+	v = 0;
+	for (int shift = 0; shift < 64 && pos < buf.size(); shift += 7) {
+		uint8_t b = buf[pos++];
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if (!(b & 0x80)) return true;
+	}
+	return false;
+}
+
+//  FNV-1a
+//
+static uint64_t hashBytes(uint64_t h, const void *data, size_t n) {
+	const uint8_t *p = (const uint8_t *)data;
+	for (size_t i = 0; i < n; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static const uint64_t hashSeed = 0xcbf29ce484222325ULL;
+
+InputLog::InputLog() {
+	step = 1.0 / 120;
+	seed = 0x5EED;
+	terrainHash = 0;
+	startTick = 0;
+	rot = angularVel = 0;
+	fuel = 0;
+	collisionVel = 0;
+	bThruster = false;
+	bLife = true;
+	bInside = false;
+	endTick = 0;
+	endHash = 0;
+	bRecording = false;
+}
+
+void InputLog::begin(LanderSim &sim) {
+	events.clear();
+	params = sim.params;
+	step = sim.clock.dt();
+	seed = 0x5EED ^ sim.clock.ticks;
+	sim.setSeed(seed);
+	terrainHash = sim.octree ? meshHash(sim.octree->mesh) : 0;
+	landerBounds = sim.landerBounds;
+
+	startTick = sim.clock.ticks;
+	const Particle &p = sim.sys.particles[0];
+	position = p.position;
+	velocity = p.velocity;
+	forces = p.forces;
+	rot = p.rot;
+	angularVel = p.angularVel;
+	thrustX = sim.thrustForceX->thrustForce;
+	thrustY = sim.thrustForceY->thrustForce;
+	thrustZ = sim.thrustForceZ->thrustForce;
+	fuel = sim.fuel;
+	collisionVel = sim.collisionVel;
+	bThruster = sim.bThruster;
+	bLife = sim.bLife;
+	bInside = sim.bInside;
+
+	endTick = startTick;
+	endHash = 0;
+	bRecording = true;
+}
+
+void InputLog::record(uint64_t tick, int key, bool down) {
+	if (!bRecording) return;
+	InputEvent e;
+	e.tick = tick;
+	e.key = key;
+	e.down = down;
+	events.push_back(e);
+}
+
+void InputLog::end(const LanderSim &sim) {
+	endTick = sim.clock.ticks;
+	endHash = stateHash(sim);
+	bRecording = false;
+}
+
+bool InputLog::save(const string &path) const {
+	vector<uint8_t> buf;
+	buf.insert(buf.end(), magic, magic + 4);
+	put(buf, version);
+
+	put(buf, params.gravity);
+	put(buf, params.mass);
+	put(buf, params.thrust);
+	put(buf, params.turnRate);
+	put(buf, params.fuel);
+	put(buf, params.fuelRate);
+	put(buf, params.crashSpeed);
+	put(buf, params.bounceSpeed);
+	put(buf, params.bounceImpulse);
+	put(buf, params.epsilon);
+	put(buf, (uint8_t)params.bEffects);
+	put(buf, step);
+	put(buf, seed);
+	put(buf, terrainHash);
+	for (int i = 0; i < 2; i++) {
+		const Vector3 &v = landerBounds.parameters[i];
+		put(buf, ofVec3f(v.x(), v.y(), v.z()));
+	}
+
+	put(buf, startTick);
+	put(buf, position);
+	put(buf, velocity);
+	put(buf, forces);
+	put(buf, rot);
+	put(buf, angularVel);
+	put(buf, thrustX);
+	put(buf, thrustY);
+	put(buf, thrustZ);
+	put(buf, fuel);
+	put(buf, collisionVel);
+	put(buf, (uint8_t)bThruster);
+	put(buf, (uint8_t)bLife);
+	put(buf, (uint8_t)bInside);
+
+	put(buf, endTick);
+	put(buf, endHash);
+
+	putVarint(buf, events.size());
+	uint64_t last = startTick;
+	for (const InputEvent &e : events) {
+		putVarint(buf, e.tick - last);
+		putVarint(buf, ((uint64_t)e.key << 1) | (e.down ? 1 : 0));
+		last = e.tick;
+	}
+
+	ofstream out(path, ios::binary);
+	if (!out) return false;
+	out.write((const char *)&buf[0], buf.size());
+	return (bool)out;
+}
+
+bool InputLog::load(const string &path) {
+	ifstream in(path, ios::binary);
+	if (!in) return false;
+	vector<uint8_t> buf((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+	size_t pos = 4;
+	uint32_t fileVersion = 0;
+	if (buf.size() < 4 || memcmp(&buf[0], magic, 4) != 0) return false;
+	if (!get(buf, pos, fileVersion) || fileVersion != version) return false;
+
+	uint8_t effects = 0, thruster = 0, life = 0, inside = 0;
+	ofVec3f bounds[2];
+	bool ok = get(buf, pos, params.gravity) &&
+		get(buf, pos, params.mass) &&
+		get(buf, pos, params.thrust) &&
+		get(buf, pos, params.turnRate) &&
+		get(buf, pos, params.fuel) &&
+		get(buf, pos, params.fuelRate) &&
+		get(buf, pos, params.crashSpeed) &&
+		get(buf, pos, params.bounceSpeed) &&
+		get(buf, pos, params.bounceImpulse) &&
+		get(buf, pos, params.epsilon) &&
+		get(buf, pos, effects) &&
+		get(buf, pos, step) &&
+		get(buf, pos, seed) &&
+		get(buf, pos, terrainHash) &&
+		get(buf, pos, bounds[0]) &&
+		get(buf, pos, bounds[1]) &&
+		get(buf, pos, startTick) &&
+		get(buf, pos, position) &&
+		get(buf, pos, velocity) &&
+		get(buf, pos, forces) &&
+		get(buf, pos, rot) &&
+		get(buf, pos, angularVel) &&
+		get(buf, pos, thrustX) &&
+		get(buf, pos, thrustY) &&
+		get(buf, pos, thrustZ) &&
+		get(buf, pos, fuel) &&
+		get(buf, pos, collisionVel) &&
+		get(buf, pos, thruster) &&
+		get(buf, pos, life) &&
+		get(buf, pos, inside) &&
+		get(buf, pos, endTick) &&
+		get(buf, pos, endHash);
+	if (!ok) return false;
+	landerBounds = Box(Vector3(bounds[0].x, bounds[0].y, bounds[0].z),
+		Vector3(bounds[1].x, bounds[1].y, bounds[1].z));
+	params.bEffects = effects != 0;
+	bThruster = thruster != 0;
+	bLife = life != 0;
+	bInside = inside != 0;
+
+	uint64_t count = 0;
+	if (!getVarint(buf, pos, count)) return false;
+	events.clear();
+	events.reserve(count);
+	uint64_t tick = startTick;
+	for (uint64_t i = 0; i < count; i++) {
+		uint64_t delta, code;
+		if (!getVarint(buf, pos, delta) || !getVarint(buf, pos, code)) return false;
+		tick += delta;
+		InputEvent e;
+		e.tick = tick;
+		e.key = (int)(code >> 1);
+		e.down = (code & 1) != 0;
+		events.push_back(e);
+	}
+	bRecording = false;
+	return true;
+}
+
+void InputLog::start(LanderSim &sim) const {
+	sim.clock.setStep(step);
+	sim.clock.ticks = startTick;
+	sim.setSeed(seed);
+	sim.setLanderBounds(landerBounds);
+
+	sim.spawn(position);
+	Particle &p = sim.sys.particles[0];
+	p.velocity = velocity;
+	p.forces = forces;
+	p.rot = rot;
+	p.angularVel = angularVel;
+	sim.thrustForceX->setForce(thrustX);
+	sim.thrustForceY->setForce(thrustY);
+	sim.thrustForceZ->setForce(thrustZ);
+	sim.fuel = fuel;
+	sim.collisionVel = collisionVel;
+	sim.bThruster = bThruster;
+	sim.bLife = bLife;
+	sim.bInside = bInside;
+	sim.bGame = false;
+}
+
+int InputLog::replay(LanderSim &sim) const {
+	start(sim);
+
+	int steps = 0;
+	size_t next = 0;
+	while (sim.clock.ticks < endTick) {
+		while (next < events.size() && events[next].tick <= sim.clock.ticks) {
+			const InputEvent &e = events[next++];
+			if (e.down) sim.keyPressed(e.key);
+			else sim.keyReleased(e.key);
+		}
+		sim.step();
+		steps++;
+	}
+	return steps;
+}
+
+//  everything about the lander that decides how the run ends
+//
+uint64_t InputLog::stateHash(const LanderSim &sim) {
+	uint64_t h = hashSeed;
+	if (sim.sys.particles.size() > 0) {
+		const Particle &p = sim.sys.particles[0];
+		h = hashBytes(h, &p.position, sizeof(p.position));
+		h = hashBytes(h, &p.velocity, sizeof(p.velocity));
+		h = hashBytes(h, &p.rot, sizeof(p.rot));
+	}
+	h = hashBytes(h, &sim.fuel, sizeof(sim.fuel));
+	h = hashBytes(h, &sim.collisionVel, sizeof(sim.collisionVel));
+	uint8_t flags = sim.bGame | (sim.bLife << 1) | (sim.bInside << 2);
+	return hashBytes(h, &flags, 1);
+}
+
+uint64_t InputLog::meshHash(const ofMesh &mesh) {
+	if (mesh.getNumVertices() == 0) return hashSeed;
+	return hashBytes(hashSeed, &mesh.getVertices()[0], mesh.getNumVertices() * sizeof(glm::vec3));
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Lunar Lander Game - input recording and replay
+//
+//  Records the lander controls as (simulation tick, key, down/up) events
+//  together with the state the run started from.  Inputs are applied
+//  between fixed steps, so replaying the events into a LanderSim at the
+//  same ticks reproduces the run bit for bit, no matter what the frame
+//  rate was while it was recorded.  A replay can run headless at full
+//  CPU speed; the end state hash tells if the physics still agrees.
+//
+//  File format (little endian): "LLIN", version, the fixed header below,
+//  then each event as two varints - tick delta, and key << 1 | down.
+//
+
+#include "ofMain.h"
+#include "LanderSim.h"
+
+class InputEvent {
+public:
+	uint64_t tick;
+	int key;
+	bool down;
+};
+
+class InputLog {
+public:
+	InputLog();
+
+	// recording: begin() right before the key that starts the game,
+	// record() every lander key, end() when the game stops
+	//
+	void begin(LanderSim &sim);
+	void record(uint64_t tick, int key, bool down);
+	void end(const LanderSim &sim);
+
+	bool save(const string &path) const;
+	bool load(const string &path);
+
+	// replay into a LanderSim that has had setup(octree, params);
+	// runs to the recorded end tick, returns the number of steps taken
+	//
+	void start(LanderSim &sim) const;
+	int replay(LanderSim &sim) const;
+	bool matches(const LanderSim &sim) const { return stateHash(sim) == endHash; }
+
+	static uint64_t stateHash(const LanderSim &sim);
+	static uint64_t meshHash(const ofMesh &mesh);
+
+	// run setup
+	//
+	LanderParams params;
+	double step;                // sim seconds per tick
+	uint64_t seed;
+	uint64_t terrainHash;
+	Box landerBounds;
+
+	// lander state at begin()
+	//
+	uint64_t startTick;
+	ofVec3f position, velocity, forces;  // lander particle
+	float rot, angularVel;
+	ofVec3f thrustX, thrustY, thrustZ;
+	float fuel;
+	float collisionVel;
+	bool bThruster;
+	bool bLife;
+	bool bInside;
+
+	// state at end()
+	//
+	uint64_t endTick;
+	uint64_t endHash;
+
+	vector<InputEvent> events;
+	bool bRecording;
+};
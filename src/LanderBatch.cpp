@@ -0,0 +1,200 @@
+
+#include "LanderBatch.h"
+#include <thread>
+#include <atomic>
+
+void BatchStats::add(const LanderSim &sim, float fuelStart, bool bTimedOut) {
+	trials++;
+	if (bTimedOut) timedOut++;
+	else {
+		if (!sim.bLife) crashed++;
+		else if (sim.bInside) landedInside++;
+		else landedOutside++;
+		touchdownSpeed += sim.collisionVel;
+	}
+	double used = fuelStart - sim.fuel;
+	fuelUsed += used;
+	fuelUsedSq += used * used;
+	simSeconds += sim.clock.now();
+}
+
+void BatchStats::merge(const BatchStats &o) {
+	trials += o.trials;
+	landedInside += o.landedInside;
+	landedOutside += o.landedOutside;
+	crashed += o.crashed;
+	timedOut += o.timedOut;
+	fuelUsed += o.fuelUsed;
+	fuelUsedSq += o.fuelUsedSq;
+	touchdownSpeed += o.touchdownSpeed;
+	simSeconds += o.simSeconds;
+}
+
+void BatchStats::print(ostream &out) const {
+	double n = MAX(trials, 1);
+	long down = trials - timedOut;
+	double fuelMean = fuelUsed / n;
+	double fuelDev = sqrt(MAX(fuelUsedSq / n - fuelMean * fuelMean, 0.0));
+
+	out << "trials: " << trials << endl;
+	out << "landed inside:  " << landedInside << " (" << 100 * landedInside / n << "%)" << endl;
+	out << "landed outside: " << landedOutside << " (" << 100 * landedOutside / n << "%)" << endl;
+	out << "crashed:        " << crashed << " (" << 100 * crashed / n << "%)" << endl;
+	out << "timed out:      " << timedOut << " (" << 100 * timedOut / n << "%)" << endl;
+	out << "fuel used: mean " << fuelMean << ", stddev " << fuelDev << endl;
+	out << "touchdown speed: mean " << (down > 0 ? touchdownSpeed / down : 0) << endl;
+	out << "simulated " << simSeconds << " s in " << wallSeconds << " s wall";
+	if (wallSeconds > 0) {
+		out << ", " << trials / wallSeconds << " trials/s ("
+			<< trials / wallSeconds * 3600 / 1e6 << "M trials/hour)";
+	}
+	out << endl;
+}
+
+LanderBatch::LanderBatch() {
+	octree = NULL;
+	control = ScriptedControl;
+	seed = 1;
+	hz = 120;
+	maxTime = 300;
+	spawnMin = ofVec3f(-40, 30, -40);
+	spawnMax = ofVec3f(40, 70, 40);
+	maxSpawnSpeed = 2;
+}
+
+void LanderBatch::setup(const Octree *terrain, const Box &bounds, const LanderParams &p) {
+	octree = terrain;
+	landerBounds = bounds;
+	params = p;
+	triangles.build(octree->mesh);
+}
+
+//  everything a trial's sim keeps from one trial to the next
+//
+void LanderBatch::setupSim(LanderSim &sim) const {
+	sim.setup(octree, params, &triangles);
+	sim.clock.setStep(1.0 / hz);
+	sim.setLanderBounds(landerBounds);
+}
+
+BatchStats LanderBatch::run(long trials, int threads) {
+	if (threads <= 0) threads = MAX((int)thread::hardware_concurrency(), 1);
+
+	// threads take trials in small chunks off a shared counter; the
+	// octree and triangle table are only read, everything else is per
+	// thread
+	//
+	const long chunk = 16;
+	atomic<long> next(0);
+	vector<BatchStats> perThread(threads);
+	vector<thread> workers;
+
+	auto t1 = chrono::steady_clock::now();
+	for (int t = 0; t < threads; t++) {
+		workers.push_back(thread([&, t]() {
+			LanderSim sim;
+			setupSim(sim);
+			long first;
+			while ((first = next.fetch_add(chunk)) < trials) {
+				long last = MIN(first + chunk, trials);
+				for (long i = first; i < last; i++) runTrial(i, sim, perThread[t]);
+			}
+		}));
+	}
+	for (auto &w : workers) w.join();
+	auto t2 = chrono::steady_clock::now();
+
+	BatchStats stats;
+	for (auto &s : perThread) stats.merge(s);
+	stats.wallSeconds = chrono::duration<double>(t2 - t1).count();
+	return stats;
+}
+
+//  the seed of one trial, hashed from the batch seed and the trial
+//  number (splitmix64): the same cost for trial 10^9 as for trial 0
+//
+static uint64_t trialSeed(uint64_t seed, long trial) {
+	uint64_t z = seed + (uint64_t)trial * 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+//  one trial on "sim", set up by setupSim(); only its per trial state is
+//  reset, so what a trial does doesn't depend on the ones before it
+//
+void LanderBatch::runTrial(long trial, LanderSim &sim, BatchStats &stats) {
+	// the pilot's draws on a stream the simulation's (0 - 3) don't use
+	//
+	uint64_t s = trialSeed(seed, trial);
+	Random rng(s, 4);
+
+	sim.reset();
+	sim.setSeed(s);
+	sim.spawn(rng.inBox(spawnMin, spawnMax));
+	sim.sys.particles[0].velocity = rng.onSphere(rng.uniform(0, maxSpawnSpeed));
+	sim.keyPressed(' ');
+
+	int maxSteps = maxTime * hz;
+	if (control == ScriptedControl) flyScripted(sim, rng, maxSteps);
+	else flyRandom(sim, rng, maxSteps);
+
+	stats.add(sim, params.fuel, sim.bGame);
+}
+
+//  a pilot with per trial skill: holds a random descent rate and steers
+//  toward the landing area, correcting only past a random tolerance
+//
+void LanderBatch::flyScripted(LanderSim &sim, Random &rng, int maxSteps) {
+	float descent = rng.uniform(0.5, 3);
+	float tolerance = rng.uniform(1, 20);
+	float maxDrift = rng.uniform(0.5, 3);
+	int keyY = 0, keyX = 0, keyZ = 0;   // key held on each axis, 0 = none
+
+	// hold "want" on an axis, releasing what was held there before
+	//
+	auto hold = [&](int &held, int want) {
+		if (held == want) return;
+		if (held) sim.keyReleased(held);
+		if (want) sim.keyPressed(want);
+		held = want;
+	};
+
+	for (int i = 0; i < maxSteps && sim.bGame; i++) {
+		const Particle &p = sim.sys.particles[0];
+
+		hold(keyY, p.velocity.y < -descent ? 'z' : 0);
+
+		int wantX = 0;
+		if (p.position.x > tolerance && p.velocity.x > -maxDrift) wantX = OF_KEY_LEFT;
+		else if (p.position.x < -tolerance && p.velocity.x < maxDrift) wantX = OF_KEY_RIGHT;
+		hold(keyX, wantX);
+
+		int wantZ = 0;
+		if (p.position.z > tolerance && p.velocity.z > -maxDrift) wantZ = OF_KEY_DOWN;
+		else if (p.position.z < -tolerance && p.velocity.z < maxDrift) wantZ = OF_KEY_UP;
+		hold(keyZ, wantZ);
+
+		sim.step();
+	}
+}
+
+//  mash the controls: every 0.1 - 1 s press or release a random key
+//
+void LanderBatch::flyRandom(LanderSim &sim, Random &rng, int maxSteps) {
+	static const int keys[] = { 'z', 'x', OF_KEY_LEFT, OF_KEY_RIGHT, OF_KEY_UP, OF_KEY_DOWN };
+	const int numKeys = sizeof(keys) / sizeof(keys[0]);
+	bool down[numKeys] = { false };
+	int nextInput = 0;
+
+	for (int i = 0; i < maxSteps && sim.bGame; i++) {
+		if (i >= nextInput) {
+			int k = MIN((int)rng.uniform(0, numKeys), numKeys - 1);
+			if (down[k]) sim.keyReleased(keys[k]);
+			else sim.keyPressed(keys[k]);
+			down[k] = !down[k];
+			nextInput = i + (int)(rng.uniform(0.1, 1) * hz);
+		}
+		sim.step();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Lunar Lander Game - batch (Monte-Carlo) landing simulator
+//
+//  Flies many independent landers against one shared, read-only Octree,
+//  spread over all cores.  Every trial is a full LanderSim driven through
+//  its keyPressed()/keyReleased() controls, so the landing rules are the
+//  ones the game uses.  The collision triangle table is built once in
+//  setup() and shared by all threads; each thread sets up one LanderSim
+//  and reset()s it between trials.  Each trial's random streams are seeded from a
+//  hash of (seed, trial), so results don't depend on the number of
+//  threads and starting a trial costs the same however many came before.
+//
+
+#include "ofMain.h"
+#include "LanderSim.h"
+#include "Random.h"
+
+enum LanderControl { ScriptedControl, RandomControl };
+
+//  What happened in one or more trials
+//
+class BatchStats {
+public:
+	void add(const LanderSim &sim, float fuelStart, bool timedOut);
+	void merge(const BatchStats &other);
+	void print(ostream &out) const;
+
+	long trials = 0;
+	long landedInside = 0;
+	long landedOutside = 0;
+	long crashed = 0;
+	long timedOut = 0;
+	double fuelUsed = 0;        // sum and sum of squares, for mean / stddev
+	double fuelUsedSq = 0;
+	double touchdownSpeed = 0;  // sum over trials that touched down
+	double simSeconds = 0;
+	double wallSeconds = 0;
+};
+
+class LanderBatch {
+public:
+	LanderBatch();
+	void setup(const Octree *terrain, const Box &landerBounds, const LanderParams &params = LanderParams());
+
+	// run "trials" landers on "threads" threads (0 = all cores)
+	//
+	BatchStats run(long trials, int threads = 0);
+	void setupSim(LanderSim &sim) const;
+	void runTrial(long trial, LanderSim &sim, BatchStats &stats);
+
+	const Octree *octree;
+	TriangleTable triangles;    // of the octree's mesh, read only
+	Box landerBounds;
+	LanderParams params;
+	LanderControl control;
+	uint64_t seed;
+	float hz;                   // physics rate
+	float maxTime;              // sim seconds before a trial counts as timed out
+	ofVec3f spawnMin, spawnMax; // spawn positions are uniform in this box
+	float maxSpawnSpeed;        // initial velocity, random direction
+
+private:
+	void flyScripted(LanderSim &sim, Random &rng, int maxSteps);
+	void flyRandom(LanderSim &sim, Random &rng, int maxSteps);
+};
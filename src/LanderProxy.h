@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "box.h"
+#include "NarrowPhase.h"
+
+//  Collision stand-in for the lander model.
+//
+//  The model's bounds are read once per model load (setLocalBounds()).
+//  The world box and the turned OBB are only recomputed when the
+//  transform actually changes: a pure move shifts the cached boxes,
+//  only a new rotation rebuilds the OBB.  Queries in the frame loop
+//  then cost nothing and never go back to the Assimp scene.
+//
+class LanderProxy {
+public:
+	LanderProxy() {
+		local = world = Box(Vector3(0, 0, 0), Vector3(0, 0, 0));
+		position.set(0, 0, 0);
+		rot = 0;
+		updates = 0;
+		bLoaded = false;
+	}
+
+	void setLocalBounds(const Box &bounds) {
+		local = bounds;
+		bLoaded = true;
+		rebuild();
+	}
+
+	void setTransform(const ofVec3f &pos, float degrees = 0) {
+		if (degrees != rot) {
+			position = pos;
+			rot = degrees;
+			rebuild();
+		}
+		else if (pos != position) {
+			ofVec3f d = pos - position;
+			position = pos;
+			box.center += d;
+			Vector3 v(d.x, d.y, d.z);
+			world = Box(world.parameters[0] + v, world.parameters[1] + v);
+			updates++;
+		}
+	}
+
+	const Box &localBounds() const { return local; }
+	const Box &worldBounds() const { return world; }  // world aligned, around obb()
+	const OBB &obb() const { return box; }
+	const ofVec3f &getPosition() const { return position; }
+	bool isLoaded() const { return bLoaded; }
+
+	int updates;        // number of times the cached boxes changed
+
+private:
+	void rebuild() {
+		box = OBB(local, position, rot);
+		world = box.bounds();
+		updates++;
+	}
+
+	Box local;
+	Box world;
+	OBB box;
+	ofVec3f position;
+	float rot;
+	bool bLoaded;
+};
@@ -0,0 +1,396 @@
+
+//--------------------------------------------------------------
+//
+//  Lunar Lander Game - simulation core
+//
+//  Game logic moved out of ofApp (originally by Jonathan Nguyen) so it
+//  can run without a window.
+//
+
+#include "LanderSim.h"
+
+LanderSim::LanderSim() {
+	octree = NULL;
+	gravityForce = NULL;
+	thrustForceX = thrustForceY = thrustForceZ = NULL;
+	turbForce = NULL;
+	radialForce = NULL;
+	fuel = 0;
+	altitude = 0;
+	bThruster = false;
+	bGame = false;
+	bLife = true;
+	bInside = false;
+	bStarted = false;
+	collisionVel = 0;
+	speed = 0;
+}
+
+LanderSim::~LanderSim() {
+	delete gravityForce;
+	delete thrustForceX;
+	delete thrustForceY;
+	delete thrustForceZ;
+	delete turbForce;
+	delete radialForce;
+}
+
+// "triangles", if given, is the octree mesh's TriangleTable, built once
+// and shared by several sims instead of one copy each
+//
+void LanderSim::setup(const Octree *terrain, const LanderParams &p, const TriangleTable *triangles) {
+	octree = terrain;
+	params = p;
+	exhaustCollider.setup(octree, 1);
+	narrowPhase.setup(octree, triangles);
+	narrowPhase.skin = params.epsilon;
+	altitudeQuery.setup(octree);
+
+	//Forces, thrusts have no initial force
+	gravityForce = new GravityForce(ofVec3f(0, -params.gravity, 0)); //moon's gravity
+	thrustForceX = new ThrustForce(ofVec3f(0, 0, 0));
+	thrustForceY = new ThrustForce(ofVec3f(0, 0, 0));
+	thrustForceZ = new ThrustForce(ofVec3f(0, 0, 0));
+
+	//forces for emitters
+	radialForce = new ImpulseRadialForce(1000.0);
+	turbForce = new TurbulenceForce(glm::vec3(-90, -90, -90),
+		glm::vec3(90, 90, 90));
+
+	targetArea = Box(Vector3(-24.6, -1, 5. - 24.6), Vector3(24.6, 1.5, 24.6));
+
+	sys.addForce(gravityForce);
+	sys.addForce(thrustForceX);
+	sys.addForce(thrustForceY);
+	sys.addForce(thrustForceZ);
+
+	explodeEmitter.sys->addForce(radialForce);
+	explodeEmitter.setVelocity(ofVec3f(0, 0, 0));
+	explodeEmitter.setOneShot(true);
+	explodeEmitter.setEmitterType(RadialEmitter);
+	explodeEmitter.setGroupSize(500);
+
+	thrustEmitter.velocity = glm::vec3(0, -15, 0);
+	thrustEmitter.rate = 70;
+	thrustEmitter.setEmitterType(DirectionalEmitter);
+	thrustEmitter.setGroupSize(70);
+	thrustEmitter.lifespan = 0.15;
+	thrustEmitter.setParticleRadius(0.05);
+	thrustEmitter.sys->addForce(turbForce);
+
+	reset();
+}
+
+// back to the state setup() leaves, before spawn(): no particles, full
+// tank, game not started, clock at 0.  Keeps everything that only
+// depends on the terrain (the collision tables, the exhaust collider's
+// cells, the forces), so the next run starts without rebuilding them
+//
+void LanderSim::reset() {
+	player = Particle();
+	player.mass = params.mass;
+	player.lifespan = -1;
+	sys.particles.clear();
+
+	// the proxy moves its boxes by the change in position, so start it
+	// from the origin again rather than from where the last run ended
+	//
+	bool bBounds = proxy.isLoaded();
+	proxy = LanderProxy();
+	if (bBounds) proxy.setLocalBounds(landerBounds);
+	sys.gridValid = false;
+
+	thrustForceX->setForce(ofVec3f(0, 0, 0));
+	thrustForceY->setForce(ofVec3f(0, 0, 0));
+	thrustForceZ->setForce(ofVec3f(0, 0, 0));
+	for (ParticleEmitter *e : { &thrustEmitter, &explodeEmitter }) {
+		e->stop();
+		e->lastSpawned = e->lastUpdate = 0;
+		e->sys->particles.clear();
+		e->sys->gridValid = false;
+		e->sys->reset();
+	}
+
+	clock.reset();
+	narrowPhase.query.reset();
+	altitudeQuery.reset();
+	contact.clear();
+
+	fuel = params.fuel;
+	altitude = 0;
+	bThruster = false;
+	bStarted = false;
+	bGame = false;
+	bLife = true;
+	bInside = false;
+	collisionVel = 0;
+	speed = 0;
+	vel = norm = glm::vec3(0, 0, 0);
+}
+
+// place the lander (and its physics particle) at pos
+//
+void LanderSim::spawn(const ofVec3f &pos) {
+	player.position = pos;
+	player.prevPosition = pos;
+	sys.particles.clear();
+	sys.add(player);
+	narrowPhase.query.reset();
+	altitudeQuery.reset();
+}
+
+// reseed every random stream the simulation uses (emitters and the
+// exhaust/explosion forces) so a run only depends on its seed and inputs
+//
+void LanderSim::setSeed(uint64_t seed) {
+	thrustEmitter.rng.seed(seed, 0);
+	explodeEmitter.rng.seed(seed, 1);
+	if (turbForce) turbForce->rng.seed(seed, 2);
+	if (radialForce) radialForce->rng.seed(seed, 3);
+}
+
+// Advance the simulation by one fixed step (one clock tick)
+//
+void LanderSim::step() {
+	PROFILE_ZONE("sim.step");
+
+	//Only move the craft when game is running
+	//
+	if (bGame == true) {
+		{
+			PROFILE_ZONE("sys.update");
+			sys.update(clock);
+		}
+
+		if (sys.particles.size() > 0) {
+			player.position = sys.particles[0].position;
+		}
+
+		thrustEmitter.setPosition(player.position);
+	}
+
+	// thrusters and fuel
+	//
+	if (bThruster == true && fuel >= 0 && bGame == true) {
+		if (!thrustEmitter.started) thrustEmitter.start();
+		fuel -= params.fuelRate * clock.dt();
+	}
+	else {
+		thrustEmitter.stop();
+	}
+
+	if (params.bEffects) {
+		PROFILE_ZONE("emitters");
+		for (auto& p : explodeEmitter.sys->particles) {
+			p.position.set(ofVec3f(player.position));
+		}
+
+		explodeEmitter.update(clock);
+		thrustEmitter.update(clock);
+		exhaustCollider.collide(*thrustEmitter.sys, 0.3);
+	}
+
+	checkCollision();
+
+	clock.tick();
+}
+
+bool LanderSim::keyPressed(int key) {
+	float t = params.thrust;
+
+	switch (key) {
+	case 'A':
+	case 'a':
+		bThruster = true;
+		player.angularVel = -params.turnRate;
+		break;
+	case 'D':
+	case 'd':
+		bThruster = true;
+		player.angularVel = params.turnRate;
+		break;
+	case 'X':
+	case 'x':
+		thrustForceY->setForce(ofVec3f(0, -t, 0));
+		bThruster = true;
+		break;
+	case 'Z':
+	case 'z':
+		thrustForceY->setForce(ofVec3f(0, t, 0));
+		bThruster = true;
+		break;
+	case OF_KEY_UP:
+		thrustForceZ->setForce(ofVec3f(0, 0, t));
+		bThruster = true;
+		break;
+	case OF_KEY_DOWN:
+		thrustForceZ->setForce(ofVec3f(0, 0, -t));
+		bThruster = true;
+		break;
+	case OF_KEY_LEFT:
+		thrustForceX->setForce(ofVec3f(-t, 0, 0));
+		bThruster = true;
+		break;
+	case OF_KEY_RIGHT:
+		thrustForceX->setForce(ofVec3f(t, 0, 0));
+		bThruster = true;
+		break;
+	case ' ':
+		bStarted = true;
+		bGame = true;
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+bool LanderSim::keyReleased(int key) {
+
+	switch (key) {
+	case 'A':
+	case 'a':
+	case 'D':
+	case 'd':
+		bThruster = false;
+		player.angularVel = 0;
+		break;
+	case 'X':
+	case 'x':
+	case 'Z':
+	case 'z':
+		thrustForceY->setForce(ofVec3f(0, 0, 0));
+		bThruster = false;
+		break;
+	case OF_KEY_UP:
+	case OF_KEY_DOWN:
+		thrustForceZ->setForce(ofVec3f(0, 0, 0));
+		bThruster = false;
+		break;
+	case OF_KEY_LEFT:
+	case OF_KEY_RIGHT:
+		thrustForceX->setForce(ofVec3f(0, 0, 0));
+		bThruster = false;
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+// Check if a collision is occuring: the lander's box against the
+// terrain triangles under it.  The box isn't turned by p.rot, since the
+// model is drawn with a fixed rotation and the two must match
+void LanderSim::checkCollision() {
+	PROFILE_ZONE("checkCollision");
+
+	if (sys.particles.size() == 0) return;
+	Particle &p = sys.particles[0];
+
+	proxy.setTransform(p.position);
+	if (narrowPhase.collide(proxy.obb(), contact) > 0) {
+		norm = contact.normal;
+		vel = p.velocity;
+
+		// push the lander back out of the ground
+		if (contact.depth > 0 && bGame == true) {
+			p.position += contact.normal * contact.depth;
+			player.position = p.position;
+		}
+
+		speed = glm::length(vel);
+		collisionVel = fmaxf(collisionVel, speed);
+		resolveCollision();
+	}
+
+}
+
+// Resolve collision based on speed and area landed
+void LanderSim::resolveCollision() {
+
+	if (bGame == true) {
+
+		if (speed >= params.crashSpeed) {
+			//too fast, crashed
+			explodeEmitter.start();
+
+			bLife = false; //Very much dead
+			bGame = false;
+		}
+
+		if (speed > params.bounceSpeed && speed < params.crashSpeed && bGame == true) {
+			//not a smooth landing, bounce
+
+			// only while moving into the ground: the contact lasts several
+			// steps at high rates, and a second impulse on the way out
+			// would throw the lander back down
+			//
+			float vn = glm::dot(vel, norm);
+			glm::vec3 impulseForce = params.bounceImpulse * (-vn * norm);
+			//from the lecture slides
+
+			if (sys.particles.size() > 0 && vn < 0) {
+				sys.particles[0].forces += impulseForce / clock.dt();
+			}
+
+		}
+		else { //lander safely landed
+			bGame = false; //stop the game... integrate should stop too
+
+			//if we land inside the area
+			if (targetArea.inside(Vec4::of(player.position))) {
+
+				bInside = true;
+			}
+			else { //outside the target area
+				bInside = false;
+			}
+
+		}
+	}
+}
+
+void LanderSim::printMemory(ostream &os) const {
+	if (octree != NULL) octree->memory().print(os);
+
+	auto particles = [&](const string &name, const ParticleSystem &s) {
+		os << name << " particles: " << s.particles.size() << " live, " << s.particles.capacity()
+			<< " capacity, " << s.particles.capacity() * sizeof(Particle) / 1024 << " KB" << endl;
+	};
+	particles("lander", sys);
+	particles("thrust", *thrustEmitter.sys);
+	particles("explosion", *explodeEmitter.sys);
+
+	os << "narrow phase tables: " << narrowPhase.table().bytes() / 1024 << " KB" << endl;
+}
+
+void LanderSim::printQueries(ostream &os) const {
+	auto print = [&](const string &name, const CoherentStats &s) {
+		os << name << " queries: " << s.queries << ", " << s.hitRate() * 100 << "% from the cached cell, "
+			<< s.nodesPerQuery() << " nodes/query" << endl;
+	};
+	print("collision", narrowPhase.query.stats);
+	print("altitude", altitudeQuery.stats);
+}
+
+//Get the current altitude using ray-intersect
+void LanderSim::calculateAltitude(){
+	PROFILE_ZONE("calculateAltitude");
+	Vector3 landerPosition = toVector3(player.position);
+
+	Ray altitudeRadar = Ray(landerPosition, Vector3(0, -1, 0)); //straight down
+	// the ground is the nearest point leaf under the lander, searched
+	// from where last frame's was found
+	//
+	int point;
+	float t;
+	if (altitudeQuery.intersectNearest(altitudeRadar, point, t)) {
+
+		//if intersected, get the altitude
+		altitude = glm::distance(glm::vec3(player.position),
+			glm::vec3(octree->mesh.getVertex(point)));
+
+
+	}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+//--------------------------------------------------------------
+//
+//  Lunar Lander Game - simulation core
+//
+//  Everything the game needs to run except drawing: lander physics,
+//  thrusters and fuel, terrain collision, landing rules and the particle
+//  effects.  It only needs a built Octree and the lander's bounds, so it
+//  runs the same inside ofApp or in a headless program with no window,
+//  GL context or frame clock (see tools/headless).
+//
+
+#include "ofMain.h"
+#include "Octree.h"
+#include "ParticleSystem.h"
+#include "ParticleEmitter.h"
+#include "TerrainCollider.h"
+#include "NarrowPhase.h"
+#include "CoherentQuery.h"
+#include "LanderProxy.h"
+#include "SimClock.h"
+#include "Profiler.h"
+
+//  Gameplay tuning
+//
+class LanderParams {
+public:
+	float gravity = 1.62;       // moon's gravity is 1.62 m/s^2
+	float mass = 50;
+	float thrust = 100;         // per axis
+	float turnRate = 30;        // deg/sec (A/D)
+	float fuel = 2500;
+	float fuelRate = 60;        // fuel used per second of thrust
+	float crashSpeed = 5;       // touchdown at or above this is a crash
+	float bounceSpeed = 0.5;    // above this (and below crash) the lander bounces
+	float bounceImpulse = 100;
+	float epsilon = 0.05;       // contact distance to terrain (narrow phase skin)
+	bool bEffects = true;       // exhaust and explosion particles
+};
+
+class LanderSim {
+public:
+	LanderSim();
+	~LanderSim();
+	void setup(const Octree *terrain, const LanderParams &params = LanderParams(),
+		const TriangleTable *triangles = NULL);
+	void reset();
+	void setLanderBounds(const Box &localBounds) {
+		landerBounds = localBounds;
+		proxy.setLocalBounds(localBounds);
+	}
+	void spawn(const ofVec3f &pos);
+	void setSeed(uint64_t seed);
+	void step();
+
+	// game controls, return true if the key is one of them
+	//
+	bool keyPressed(int key);
+	bool keyReleased(int key);
+
+	void checkCollision();
+	void resolveCollision();
+	void calculateAltitude();
+
+	// octree, particle and collision table sizes
+	//
+	void printMemory(ostream &os) const;
+
+	// hit rates and nodes tested of the per-frame octree queries
+	//
+	void printQueries(ostream &os) const;
+
+	const Octree *octree;
+	Box landerBounds;           // lander model bounds, relative to its position
+	LanderProxy proxy;          // lander collision box, follows sys.particles[0]
+	LanderParams params;
+	SimClock clock;
+
+	Particle player;            // mirror of sys.particles[0]
+	ParticleSystem sys;
+	ThrustForce *thrustForceX;  //left and right
+	ThrustForce *thrustForceY;  //up and down
+	ThrustForce *thrustForceZ;  //fwd and back
+	GravityForce *gravityForce; //down only
+	TurbulenceForce *turbForce; //for thruster emitter
+	ImpulseRadialForce *radialForce;
+	ParticleEmitter thrustEmitter; //movement
+	ParticleEmitter explodeEmitter; //for crashing
+	TerrainCollider exhaustCollider; //thrust particles bounce off the ground
+	NarrowPhase narrowPhase;    //lander box vs. terrain triangles
+	CoherentQuery altitudeQuery; //altitude radar, follows the lander
+	ContactManifold contact;    //last terrain contact
+
+	float fuel;
+	float altitude;
+	Box targetArea;             //place to land
+
+	bool bThruster;             //thrusters on or not
+	bool bGame;                 //game running or not
+	bool bLife;                 //intact or combusted?
+	bool bInside;               //landed inside or not
+	bool bStarted;              //standby at the beginning
+
+	float collisionVel;
+	float speed;
+	glm::vec3 vel;
+	glm::vec3 norm;
+};
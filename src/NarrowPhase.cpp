@@ -0,0 +1,296 @@
+
+#include "NarrowPhase.h"
+#include <cfloat>
+
+OBB::OBB() {
+	center.set(0, 0, 0);
+	axis[0].set(1, 0, 0);
+	axis[1].set(0, 1, 0);
+	axis[2].set(0, 0, 1);
+	half.set(0, 0, 0);
+}
+
+OBB::OBB(const Box &local, const ofVec3f &position, float rot) {
+	Vector3 min = local.parameters[0];
+	Vector3 max = local.parameters[1];
+	ofVec3f c((min.x() + max.x()) / 2, (min.y() + max.y()) / 2, (min.z() + max.z()) / 2);
+	half.set((max.x() - min.x()) / 2, (max.y() - min.y()) / 2, (max.z() - min.z()) / 2);
+
+	float r = ofDegToRad(rot);
+	float cs = cos(r), sn = sin(r);
+	axis[0].set(cs, 0, -sn);
+	axis[1].set(0, 1, 0);
+	axis[2].set(sn, 0, cs);
+	center = position + axis[0] * c.x + axis[1] * c.y + axis[2] * c.z;
+}
+
+Box OBB::bounds() const {
+	ofVec3f e;
+	for (int k = 0; k < 3; k++) {
+		e[k] = fabs(axis[0][k]) * half.x + fabs(axis[1][k]) * half.y + fabs(axis[2][k]) * half.z;
+	}
+	return Box(toVector3(center - e), toVector3(center + e));
+}
+
+void TriangleTable::build(const ofMesh &mesh) {
+	int nv = mesh.getNumVertices();
+
+	// triangles from the index list, or every three vertices if there is none
+	//
+	triangles.clear();
+	if (mesh.getNumIndices() > 0) {
+		for (int i = 0; i + 2 < mesh.getNumIndices(); i += 3) {
+			triangles.push_back(mesh.getIndex(i));
+			triangles.push_back(mesh.getIndex(i + 1));
+			triangles.push_back(mesh.getIndex(i + 2));
+		}
+	}
+	else {
+		for (int i = 0; i + 2 < nv; i += 3) {
+			triangles.push_back(i);
+			triangles.push_back(i + 1);
+			triangles.push_back(i + 2);
+		}
+	}
+	int nt = triangles.size() / 3;
+
+	// vertex -> triangles, counted then filled; longest edge on the way
+	//
+	vertTriStart.assign(nv + 1, 0);
+	margin = 0;
+	for (int t = 0; t < nt; t++) {
+		for (int k = 0; k < 3; k++) {
+			int a = triangles[t * 3 + k];
+			int b = triangles[t * 3 + (k + 1) % 3];
+			vertTriStart[a + 1]++;
+			margin = MAX(margin, glm::distance(mesh.getVertex(a), mesh.getVertex(b)));
+		}
+	}
+	for (int v = 0; v < nv; v++) vertTriStart[v + 1] += vertTriStart[v];
+	vertTris.resize(vertTriStart[nv]);
+	vector<int> fill(vertTriStart.begin(), vertTriStart.end() - 1);
+	for (int t = 0; t < nt; t++) {
+		for (int k = 0; k < 3; k++) vertTris[fill[triangles[t * 3 + k]]++] = t;
+	}
+
+	// any point of a triangle is within longest edge / sqrt(3) of one of
+	// its corners, so that is how far the vertex query has to reach
+	//
+	margin /= sqrt(3.0f);
+}
+
+size_t TriangleTable::bytes() const {
+	return (vertTriStart.capacity() + vertTris.capacity() + triangles.capacity()) * sizeof(int);
+}
+
+NarrowPhase::NarrowPhase() {
+	octree = NULL;
+	voxels = NULL;
+	skin = 0.05;
+	shared = NULL;
+	mark = 0;
+}
+
+void NarrowPhase::setup(const Octree *o, const TriangleTable *s) {
+	octree = o;
+	query.setup(octree);
+	shared = s;
+	if (shared == NULL) own.build(octree->mesh);
+	triMark.assign(table().triangles.size() / 3, 0);
+	mark = 0;
+}
+
+//  closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+//
+static ofVec3f closestOnTriangle(const ofVec3f &p, const ofVec3f &a, const ofVec3f &b, const ofVec3f &c) {
+	ofVec3f ab = b - a, ac = c - a, ap = p - a;
+	float d1 = ab.dot(ap), d2 = ac.dot(ap);
+	if (d1 <= 0 && d2 <= 0) return a;
+
+	ofVec3f bp = p - b;
+	float d3 = ab.dot(bp), d4 = ac.dot(bp);
+	if (d3 >= 0 && d4 <= d3) return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+	ofVec3f cp = p - c;
+	float d5 = ab.dot(cp), d6 = ac.dot(cp);
+	if (d6 >= 0 && d5 <= d6) return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denom = 1 / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+//  separating axis test of the box (grown by "skin") against triangle
+//  abc, done in the box's frame.  On overlap fills in the normal and
+//  depth of least penetration and a contact point on the triangle.
+//
+bool NarrowPhase::boxTriangle(const OBB &box, const ofVec3f &a, const ofVec3f &b, const ofVec3f &c,
+	float skin, ContactPoint &contact) {
+
+	ofVec3f v[3];
+	const ofVec3f *w[3] = { &a, &b, &c };
+	for (int i = 0; i < 3; i++) {
+		ofVec3f d = *w[i] - box.center;
+		v[i].set(d.dot(box.axis[0]), d.dot(box.axis[1]), d.dot(box.axis[2]));
+	}
+	ofVec3f h = box.half + ofVec3f(skin, skin, skin);
+	ofVec3f e[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+
+	float best = FLT_MAX;
+	ofVec3f bestAxis;
+
+	// project onto n; false if separated, else keep the smaller push
+	//
+	auto test = [&](const ofVec3f &n) -> bool {
+		float len2 = n.lengthSquared();
+		if (len2 < 1e-12f) return true;     // parallel edges, no axis
+		float p0 = v[0].dot(n), p1 = v[1].dot(n), p2 = v[2].dot(n);
+		float tmin = MIN(p0, MIN(p1, p2));
+		float tmax = MAX(p0, MAX(p1, p2));
+		float r = h.x * fabs(n.x) + h.y * fabs(n.y) + h.z * fabs(n.z);
+		if (tmin > r || tmax < -r) return false;
+
+		float len = sqrt(len2);
+		float up = (tmax + r) / len;        // move the box along +n
+		float down = (r - tmin) / len;      // or along -n
+		if (up < best) { best = up; bestAxis = n / len; }
+		if (down < best) { best = down; bestAxis = -n / len; }
+		return true;
+	};
+
+	// box faces
+	//
+	for (int k = 0; k < 3; k++) {
+		ofVec3f n(0, 0, 0);
+		n[k] = 1;
+		if (!test(n)) return false;
+	}
+
+	// edge cross products
+	//
+	for (int k = 0; k < 3; k++) {
+		ofVec3f u(0, 0, 0);
+		u[k] = 1;
+		for (int j = 0; j < 3; j++) {
+			if (!test(u.getCrossed(e[j]))) return false;
+		}
+	}
+
+	// triangle face: the terrain is one sided, so the box only ever
+	// leaves along the outward normal.  Ties go to the face so resting
+	// contacts get the surface normal rather than an edge direction.
+	//
+	ofVec3f n = e[0].getCrossed(v[2] - v[0]);
+	float len = n.length();
+	if (len > 1e-12f) {
+		n /= len;
+		float d = v[0].dot(n);
+		float r = h.x * fabs(n.x) + h.y * fabs(n.y) + h.z * fabs(n.z);
+		if (d > r || d < -r) return false;
+		float up = d + r;
+		if (up <= best * 1.05f + 1e-4f) {
+			best = up;
+			bestAxis = n;
+		}
+	}
+
+	contact.normal = box.axis[0] * bestAxis.x + box.axis[1] * bestAxis.y + box.axis[2] * bestAxis.z;
+	contact.depth = best - skin;
+	contact.point = closestOnTriangle(box.center, a, b, c);
+	return true;
+}
+
+int NarrowPhase::collide(const OBB &box, ContactManifold &manifold) {
+	manifold.clear();
+	if (octree == NULL) return 0;
+
+	// broad phase: nothing if the voxels around the box are all free,
+	// else leaf vertices near the box, then their triangles
+	//
+	Box q = box.bounds();
+	if (voxels != NULL) {
+		Vector3 s(skin, skin, skin);
+		if (voxels->empty(Box(q.parameters[0] - s, q.parameters[1] + s))) return 0;
+	}
+	const TriangleTable &tt = table();
+	float g = tt.margin + skin;
+	Box grown(q.parameters[0] - Vector3(g, g, g), q.parameters[1] + Vector3(g, g, g));
+	points.clear();
+	query.intersect(grown, points);
+
+	if (++mark == 0) {
+		fill(triMark.begin(), triMark.end(), 0);
+		mark = 1;
+	}
+
+	// triangles whose bounds miss the box's bounds are skipped before the SAT
+	//
+	Vec4 s(skin, skin, skin);
+	Vec4 qmin = Vec4::load3(q.parameters[0]) - s;
+	Vec4 qmax = Vec4::load3(q.parameters[1]) + s;
+
+	const glm::vec3 *verts = octree->mesh.getVerticesPointer();
+	found.clear();
+	ContactPoint contact;
+	for (int i = 0; i < points.size(); i++) {
+		int v = points[i];
+		for (int k = tt.vertTriStart[v]; k < tt.vertTriStart[v + 1]; k++) {
+			int t = tt.vertTris[k];
+			if (triMark[t] == mark) continue;
+			triMark[t] = mark;
+
+			const int *tri = &tt.triangles[t * 3];
+			Vec4 a = Vec4::of(verts[tri[0]]);
+			Vec4 b = Vec4::of(verts[tri[1]]);
+			Vec4 c = Vec4::of(verts[tri[2]]);
+			if (!Vec4::allLessEqual3(qmin, Vec4::max(a, Vec4::max(b, c))) ||
+				!Vec4::allLessEqual3(Vec4::min(a, Vec4::min(b, c)), qmax)) continue;
+
+			if (boxTriangle(box, verts[tri[0]], verts[tri[1]], verts[tri[2]], skin, contact)) {
+				contact.triangle = t;
+				found.push_back(contact);
+			}
+		}
+	}
+
+	reduce(manifold);
+	return manifold.points.size();
+}
+
+//  keep the deepest contact, then repeatedly the one farthest from those
+//  already kept, up to four
+//
+void NarrowPhase::reduce(ContactManifold &manifold) {
+	int n = found.size();
+	if (n == 0) return;
+
+	int deepest = 0;
+	ofVec3f normal(0, 0, 0);
+	for (int i = 0; i < n; i++) {
+		if (found[i].depth > found[deepest].depth) deepest = i;
+		normal += found[i].normal * MAX(found[i].depth + skin, 1e-4f);
+	}
+	manifold.depth = found[deepest].depth;
+	manifold.normal = normal.getNormalized();
+
+	manifold.points.push_back(found[deepest]);
+	while (manifold.points.size() < 4 && manifold.points.size() < n) {
+		int far = -1;
+		float farDist = -1;
+		for (int i = 0; i < n; i++) {
+			float d = FLT_MAX;
+			for (auto &p : manifold.points) d = MIN(d, p.point.squareDistance(found[i].point));
+			if (d > farDist) { farDist = d; far = i; }
+		}
+		if (farDist < 1e-8f) break;     // the rest are duplicates
+		manifold.points.push_back(found[far]);
+	}
+}
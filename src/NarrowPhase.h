@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Octree.h"
+#include "CoherentQuery.h"
+#include "VoxelOctree.h"
+
+//  Oriented box: center, three unit axes and the half size along each
+//
+class OBB {
+public:
+	OBB();
+
+	// a box given in local coordinates (like the lander's model bounds),
+	// turned "rot" degrees about Y and moved to "position"
+	//
+	OBB(const Box &local, const ofVec3f &position, float rot = 0);
+
+	Box bounds() const;     // world aligned box around it
+
+	ofVec3f center;
+	ofVec3f axis[3];
+	ofVec3f half;
+};
+
+class ContactPoint {
+public:
+	ofVec3f point;          // on the terrain surface
+	ofVec3f normal;         // out of the terrain, toward the box
+	float depth;            // penetration along normal, > 0 overlapping
+	int triangle;
+};
+
+//  Up to four contact points plus one combined normal and depth, the
+//  deepest penetration.  Empty when nothing touches.
+//
+class ContactManifold {
+public:
+	void clear() { points.clear(); depth = 0; normal.set(0, 0, 0); }
+	bool empty() const { return points.empty(); }
+
+	vector<ContactPoint> points;
+	ofVec3f normal;
+	float depth = 0;
+};
+
+//  The terrain's triangles and, for each vertex, the triangles using it
+//  (offset table + list).  Read only once built, so one table can serve
+//  every NarrowPhase on the same mesh: LanderBatch builds one for all
+//  its threads.
+//
+class TriangleTable {
+public:
+	void build(const ofMesh &mesh);
+	size_t bytes() const;
+
+	vector<int> vertTriStart;
+	vector<int> vertTris;
+	vector<int> triangles;  // 3 vertex indices per triangle
+	float margin = 0;       // longest terrain edge / sqrt(3)
+};
+
+//  Box vs. terrain triangle narrow phase.
+//
+//  Candidate triangles come from the octree: the leaf vertices near the
+//  box (the query is grown by "margin" so big triangles whose corners are
+//  all outside the box are still found), then every triangle using one
+//  of those vertices.  The octree query starts from the cell that held
+//  the last frame's box (see CoherentQuery).  Each candidate is tested with
+//  the separating axis test (3 box axes, the triangle normal, 9 edge
+//  cross products); the axis of least overlap gives the contact normal
+//  and depth.  Contacts from all triangles are reduced to at most four
+//  that span the contact area.
+//
+//  If "voxels" is set (a VoxelOctree of the same mesh), a box with no
+//  occupied voxel within "skin" of it returns no contacts before any of
+//  that: no triangle can be near it.
+//
+//  setup() builds the triangle table of the octree's mesh, unless it is
+//  given one already built for that mesh.
+//
+class NarrowPhase {
+public:
+	NarrowPhase();
+	void setup(const Octree *octree, const TriangleTable *shared = NULL);
+	int collide(const OBB &box, ContactManifold &manifold);
+	const TriangleTable &table() const { return shared ? *shared : own; }
+
+	static bool boxTriangle(const OBB &box, const ofVec3f &a, const ofVec3f &b, const ofVec3f &c,
+		float skin, ContactPoint &contact);
+
+	const Octree *octree;
+	CoherentQuery query;    // the broad phase octree query
+	const VoxelOctree *voxels;  // optional, tried before the octree
+	float skin;             // boxes this close count as touching
+
+private:
+	const TriangleTable *shared;    // built elsewhere, or NULL to use "own"
+	TriangleTable own;
+	vector<int> points;
+	vector<uint32_t> triMark;   // triangle already tested in this query if == mark
+	uint32_t mark;
+	vector<ContactPoint> found;
+	void reduce(ContactManifold &manifold);
+};
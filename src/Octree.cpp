@@ -11,12 +11,21 @@
 
 
 #include "Octree.h"
+#include <limits>
+#include <mutex>
+
+//  the members below are defined for every OctreeT; the ones the
+//  program uses are instantiated at the end of the file
+//
+#define OCTREE_TEMPLATE template <class Index, int LeafSize, int MaxDepth, class Payload>
+#define OCTREE OctreeT<Index, LeafSize, MaxDepth, Payload>
  
 
 
 //draw a box from a "Box" class  
 //
-void Octree::drawBox(const Box &box) {
+OCTREE_TEMPLATE
+void OCTREE::drawBox(const Box &box) {
 	Vector3 min = box.parameters[0];
 	Vector3 max = box.parameters[1];
 	Vector3 size = max - min;
@@ -30,7 +39,8 @@ void Octree::drawBox(const Box &box) {
 
 // return a Mesh Bounding Box for the entire Mesh
 //
-Box Octree::meshBounds(const ofMesh & mesh) {
+OCTREE_TEMPLATE
+Box OCTREE::meshBounds(const ofMesh & mesh) {
 	int n = mesh.getNumVertices();
 	ofVec3f v = mesh.getVertex(0);
 	ofVec3f max = v;
@@ -52,16 +62,65 @@ Box Octree::meshBounds(const ofMesh & mesh) {
 	return Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
 }
 
+// bytes held by a mesh's vertex data
+//
+OCTREE_TEMPLATE
+size_t OCTREE::meshBytes(const ofMesh & m) {
+	return m.getNumVertices() * sizeof(glm::vec3) + m.getNumNormals() * sizeof(glm::vec3) +
+		m.getNumIndices() * sizeof(ofIndexType) + m.getNumColors() * sizeof(ofFloatColor) +
+		m.getNumTexCoords() * sizeof(glm::vec2);
+}
+
+template <class Node>
+static void countNodes(const Node & node, int depth, OctreeMemory & m) {
+	m.nodes++;
+	if (!node.built.isSet()) m.unbuilt++;
+	else if (node.children.empty()) m.leaves++;
+	if (m.depthNodes.size() <= depth) m.depthNodes.resize(depth + 1, 0);
+	m.depthNodes[depth]++;
+	m.pointRefs += node.points.size();
+	m.pointBytes += node.points.capacity() * sizeof(node.points[0]);
+	m.nodeBytes += node.children.capacity() * sizeof(Node);
+	for (const Node & child : node.children) countNodes(child, depth + 1, m);
+}
+
+// walk the tree and add up what it holds
+//
+OCTREE_TEMPLATE
+OctreeMemory OCTREE::memory() const {
+	OctreeMemory m;
+	m.nodeBytes = sizeof(TreeNode);     // the root
+	countNodes(root, 0, m);
+	m.meshBytes = meshBytes(mesh);
+	return m;
+}
+
+void OctreeMemory::print(ostream & os) const {
+	os << "octree: " << nodes << " nodes, " << leaves << " leaves, " << pointRefs << " point refs" << endl;
+	os << "  nodes " << nodeBytes / 1024 << " KB, point lists " << pointBytes / 1024 << " KB, mesh copy "
+		<< meshBytes / 1024 << " KB, total " << total() / 1024 << " KB" << endl;
+	if (unbuilt > 0) os << "  " << unbuilt << " nodes not expanded yet" << endl;
+	os << "  nodes per depth:";
+	for (int i = 0; i < depthNodes.size(); i++) os << " " << depthNodes[i];
+	os << endl;
+}
+
 // getMeshPointsInBox:  return an array of indices to points in mesh that are contained 
 //                      inside the Box.  Return count of points found;
 //
-int Octree::getMeshPointsInBox(const ofMesh & mesh, const vector<int>& points,
-	Box & box, vector<int> & pointsRtn)
+OCTREE_TEMPLATE
+int OCTREE::getMeshPointsInBox(const ofMesh & mesh, const vector<Index>& points,
+	const Box & box, vector<Index> & pointsRtn) const
 {
+	// vertices are read in place and tested on all three axes at once
+	//
+	const glm::vec3 *verts = mesh.getVerticesPointer();
+	Vec4 min = Vec4::load3(box.parameters[0]);
+	Vec4 max = Vec4::load3(box.parameters[1]);
 	int count = 0;
 	for (int i = 0; i < points.size(); i++) {
-		ofVec3f v = mesh.getVertex(points[i]);
-		if (box.inside(Vector3(v.x, v.y, v.z))) {
+		Vec4 v = Vec4::of(verts[points[i]]);
+		if (Vec4::allLessEqual3(min, v) && Vec4::allLessEqual3(v, max)) {
 			count++;
 			pointsRtn.push_back(points[i]);
 		}
@@ -72,8 +131,9 @@ int Octree::getMeshPointsInBox(const ofMesh & mesh, const vector<int>& points,
 // getMeshFacesInBox:  return an array of indices to Faces in mesh that are contained 
 //                      inside the Box.  Return count of faces found;
 //
-int Octree::getMeshFacesInBox(const ofMesh & mesh, const vector<int>& faces,
-	Box & box, vector<int> & facesRtn)
+OCTREE_TEMPLATE
+int OCTREE::getMeshFacesInBox(const ofMesh & mesh, const vector<Index>& faces,
+	const Box & box, vector<Index> & facesRtn) const
 {
 	int count = 0;
 	for (int i = 0; i < faces.size(); i++) {
@@ -96,7 +156,8 @@ int Octree::getMeshFacesInBox(const ofMesh & mesh, const vector<int>& faces,
 
 //  Subdivide a Box into eight(8) equal size boxes, return them in boxList;
 //
-void Octree::subDivideBox8(const Box &box, vector<Box> & boxList) {
+OCTREE_TEMPLATE
+void OCTREE::subDivideBox8(const Box &box, vector<Box> & boxList) const {
 	Vector3 min = box.parameters[0];
 	Vector3 max = box.parameters[1];
 	Vector3 size = max - min;
@@ -126,11 +187,20 @@ void Octree::subDivideBox8(const Box &box, vector<Box> & boxList) {
 	}
 }
 
-void Octree::create(const ofMesh & geo, int numLevels) {
+OCTREE_TEMPLATE
+void OCTREE::create(const ofMesh & geo, int numLevels) {
 	// initialize octree structure
 	//
+	if (geo.getNumVertices() > (size_t)numeric_limits<Index>::max() + 1) {
+		cout << "octree: " << geo.getNumVertices() << " vertices is too many for its point index type" << endl;
+		return;
+	}
 	mesh = geo;
 	int level = 0;
+	numLevels = MIN(numLevels, MaxDepth);
+	levels = numLevels;
+	strayVerts = 0;
+	numLeaf = 0;
 	root.box = meshBounds(mesh);
 	if (!bUseFaces) {
 		for (int i = 0; i < mesh.getNumVertices(); i++) {
@@ -146,6 +216,7 @@ void Octree::create(const ofMesh & geo, int numLevels) {
 	//
 	level++;
     subdivide(mesh, root, numLevels, level);
+	if (root.children.empty()) leafBuilt(root);
 }
 
 
@@ -163,7 +234,8 @@ void Octree::create(const ofMesh & geo, int numLevels) {
 //         
 //      
              
-void Octree::subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int level) {
+OCTREE_TEMPLATE
+void OCTREE::subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int level) {
 	if (level >= numLevels) return;
 	
 	// subdvide algorithm implemented here
@@ -173,9 +245,10 @@ void Octree::subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int
 
 	//my code, do not delete
 	level++;
+	int sorted = 0;
 	//then for each child box
 	for (Box b : boxList) {
-		vector<int> boxPts;
+		vector<Index> boxPts;
 		//We want to sort point data into each box
 		int count = getMeshPointsInBox(mesh, node.points, b, boxPts);
 
@@ -184,22 +257,64 @@ void Octree::subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int
 			childNode.box = b;
 			childNode.points = boxPts;
 			node.children.push_back(childNode); //add child to the tree
+			sorted += count;
 		}
 	}
+	if (sorted < node.points.size()) strayVerts += node.points.size() - sorted;
 
 	for (int i = 0; i < node.children.size(); i++) {
-		if (node.children[i].points.size() > 1) {
-			subdivide(mesh, node.children[i], numLevels, level);
+		TreeNode & child = node.children[i];
+		if (child.points.size() > LeafSize) {
+			// below the eager levels a lazy tree leaves the node to expand()
+			//
+			if (bLazy && level >= eagerLevels && level < numLevels) {
+				child.level = level;
+				child.built = BuildFlag(false);
+				continue;
+			}
+			subdivide(mesh, child, numLevels, level);
 		}
+		if (child.children.empty()) leafBuilt(child);
 	}
 
 }
 
+//  count a finished leaf and fill in its payload
+//
+OCTREE_TEMPLATE
+void OCTREE::leafBuilt(TreeNode & node) {
+	numLeaf++;
+	node.payload.build(mesh, node.points);
+}
+
+//  Expansions share one lock, they are rare next to the queries (each
+//  node expands once) and it keeps the debug counters consistent.  The
+//  flag is set only after the children are complete, so a query that
+//  sees it set reads them without locking.
+//
+static std::mutex expandLock;
+
+OCTREE_TEMPLATE
+void OCTREE::expand(const TreeNode & node) const {
+	if (node.built.isSet()) return;
+	std::lock_guard<std::mutex> lock(expandLock);
+	if (node.built.isSet()) return;     // another thread got here first
+
+	// the tree is only completed here, not changed: the node gets the
+	// children create() would have given it
+	//
+	OCTREE *tree = const_cast<OCTREE *>(this);
+	tree->subdivide(mesh, const_cast<TreeNode &>(node), levels, node.level);
+	if (node.children.empty()) tree->leafBuilt(const_cast<TreeNode &>(node));
+	node.built.set();
+}
+
 // Implement functions below for Homework project
 //
 
 //Select points that intersect a ray. Returns a node that is intersected by the ray
-bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn) {
+OCTREE_TEMPLATE
+bool OCTREE::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn) const {
 	bool intersects = false;
 
 	/*
@@ -214,12 +329,13 @@ bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn
 
 		 //This is my code, do not delete
 		//if the box only has 1 point (should also be a leaf node)
-		if (node.points.size() == 1) {
+		if (!node.points.empty() && node.points.size() <= LeafSize) {
 			nodeRtn = node;
 			return true; //we stop (select this point)
 		}
 
 		//go one level down and check the children
+		expand(node);
 		for (int i = 0; i < node.children.size(); i++) {
 			intersect(ray, node.children[i], nodeRtn);
 		}
@@ -232,7 +348,8 @@ bool Octree::intersect(const Ray &ray, const TreeNode & node, TreeNode & nodeRtn
 
 }
 
-bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn) {
+OCTREE_TEMPLATE
+bool OCTREE::intersect(const Box &box, const TreeNode & node, vector<Box> & boxListRtn) const {
 	//for part 4b
 	bool intersects = false;
 
@@ -241,7 +358,7 @@ bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn
 
 	if (node.box.overlap(box)) { //maybe I didn't implement this function correctly
 
-		if (node.points.size() == 1) { //leaf node
+		if (!node.points.empty() && node.points.size() <= LeafSize) { //leaf node
 			boxListRtn.push_back(node.box); //add leaf box to the list
 			return true;
 		}
@@ -249,6 +366,7 @@ bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn
 		//and I guess we check the children too
 		intersects = true;
 
+		expand(node);
 		for (int i = 0; i < node.children.size(); i++) {
 			intersect(box, node.children[i], boxListRtn);
 		}
@@ -260,7 +378,8 @@ bool Octree::intersect(const Box &box, TreeNode & node, vector<Box> & boxListRtn
 }
 
 //added for final project - to be able to get Node for both box and points
-bool Octree::intersect(const Box& box, TreeNode& node, vector<TreeNode>& nodeListRtn) {
+OCTREE_TEMPLATE
+bool OCTREE::intersect(const Box& box, const TreeNode& node, vector<TreeNode>& nodeListRtn) const {
 	
 	bool intersects = false;
 
@@ -269,7 +388,7 @@ bool Octree::intersect(const Box& box, TreeNode& node, vector<TreeNode>& nodeLis
 
 	if (node.box.overlap(box)) {
 
-		if (node.points.size() == 1) { //leaf node
+		if (!node.points.empty() && node.points.size() <= LeafSize) { //leaf node
 			nodeListRtn.push_back(node); //add leaf box to the list
 			return true;
 		}
@@ -277,6 +396,7 @@ bool Octree::intersect(const Box& box, TreeNode& node, vector<TreeNode>& nodeLis
 		//and I guess we check the children too
 		intersects = true;
 
+		expand(node);
 		for (int i = 0; i < node.children.size(); i++) {
 			intersect(box, node.children[i], nodeListRtn);
 		}
@@ -287,12 +407,44 @@ bool Octree::intersect(const Box& box, TreeNode& node, vector<TreeNode>& nodeLis
 	return intersects;
 }
 
-void Octree::draw(TreeNode & node, int numLevels, int level) {
+// collect the mesh points of every leaf that overlaps the box (indices only,
+// no node copies).  Used by the particle terrain collider.
+//
+// No recursion: nodes wait on a stack, children pushed last to first so
+// leaves come out in the same order.  Each level leaves at most 7
+// siblings waiting, so MaxDepth fixes the stack's size at compile time.
+//
+OCTREE_TEMPLATE
+bool OCTREE::intersect(const Box& box, const TreeNode& node, vector<Index>& pointListRtn) const {
+
+	if (!node.box.overlap(box)) return false;
+
+	const TreeNode *stack[7 * MaxDepth + 8];
+	int top = 0;
+	stack[top++] = &node;
+	while (top > 0) {
+		const TreeNode & n = *stack[--top];
+		expand(n);
+		if (n.children.size() == 0) { //leaf node
+			if (LeafSize == 1 && n.points.size() == 1) pointListRtn.push_back(n.points[0]);
+			else pointListRtn.insert(pointListRtn.end(), n.points.begin(), n.points.end());
+			continue;
+		}
+		for (int i = n.children.size() - 1; i >= 0; i--) {
+			if (n.children[i].box.overlap(box)) stack[top++] = &n.children[i];
+		}
+	}
+	return true;
+}
+
+OCTREE_TEMPLATE
+void OCTREE::draw(TreeNode & node, int numLevels, int level) {
 	
 	if (level >= numLevels) return;
 	//node.box.r
 	drawBox(node.box);
 	level++;
+	if (level < numLevels) expand(node);
 	for (int i = 0; i < node.children.size(); i++) {
 		draw(node.children[i], numLevels, level);
 	}
@@ -301,11 +453,12 @@ void Octree::draw(TreeNode & node, int numLevels, int level) {
 
 // Optional
 //
-void Octree::drawLeafNodes(TreeNode & node) {
+OCTREE_TEMPLATE
+void OCTREE::drawLeafNodes(TreeNode & /*node*/) {
 
 
 }
 
-
-
-
+template class OctreeT<int>;                // Octree
+template class OctreeT<uint16_t, 1, 16>;    // PartOctree
+template class OctreeT<uint16_t, 8, 16>;    // 8 points a leaf, compared in the bench
@@ -12,25 +12,112 @@
 #include "ofMain.h"
 #include "box.h"
 #include "ray.h"
+#include <atomic>
 
 
 
-class TreeNode {
+//  once flag for building a node's children.  Copyable, so TreeNode
+//  stays a plain value: a copy takes the state the flag has right now.
+//
+class BuildFlag {
+public:
+	BuildFlag(bool set = true) : flag(set) {}
+	BuildFlag(const BuildFlag &o) : flag(o.isSet()) {}
+	BuildFlag &operator=(const BuildFlag &o) {
+		flag.store(o.isSet(), std::memory_order_relaxed);
+		return *this;
+	}
+	bool isSet() const { return flag.load(std::memory_order_acquire); }
+	void set() { flag.store(true, std::memory_order_release); }
+
+	std::atomic<bool> flag;
+};
+
+//  leaf payload that holds nothing (it takes no room in TreeNodeT, it
+//  sits in padding).  A payload is any class with a build() like this
+//  one; the tree calls it once for every leaf, with the leaf's points.
+//
+class NoPayload {
 public:
-	Box box;
-	vector<int> points;
-	vector<TreeNode> children;
+	template <class Index> void build(const ofMesh &, const vector<Index> &) {}
+};
+
+template <class Index, class Payload = NoPayload>
+class TreeNodeT {
+public:
+	Box box = Box(Vector3(0, 0, 0), Vector3(0, 0, 0));
+	vector<Index> points;
+
+	// a lazy Octree fills these in the first time a query reaches the
+	// node (Octree::expand()), so they can change under a const node
+	//
+	mutable vector<TreeNodeT> children;
+	mutable BuildFlag built;    // children are final
+	Payload payload;            // leaves only
+	int level = 0;              // the level subdivide() builds the children at
 	//vector<Box> boxList; //comment out later
 };
 
-class Octree {
+//  a node is its box, the two vectors, and 8 bytes for the build flag, an
+//  empty payload and the level (80 bytes with 64 bit pointers)
+//
+static_assert(sizeof(TreeNodeT<int>) == sizeof(Box) + 2 * sizeof(vector<int>) + 8,
+	"TreeNodeT layout changed, update the Index notes on OctreeT");
+
+//  what an Octree holds, from Octree::memory().  Byte counts include
+//  reserved but unused vector capacity.
+//
+class OctreeMemory {
+public:
+	int nodes = 0;
+	int leaves = 0;
+	int pointRefs = 0;          // point indices over all nodes
+	vector<int> depthNodes;     // nodes at each depth, the root is depth 0
+	size_t nodeBytes = 0;       // TreeNode records
+	size_t pointBytes = 0;      // point index lists
+	size_t meshBytes = 0;       // the octree's own copy of the mesh
+	int unbuilt = 0;            // nodes a lazy tree hasn't expanded yet
+	size_t total() const { return nodeBytes + pointBytes + meshBytes; }
+	void print(ostream &os) const;
+};
+
+//  The octree, specialized at compile time:
+//
+//    Index      type of the point indices in the nodes; uint16_t halves
+//               the point lists of meshes under 65536 vertices.  The
+//               node records (80 bytes: a 24 byte box, the points and
+//               children vectors, and the flag, payload and level in 8)
+//               are most of the tree and don't change, so the whole
+//               tree only gets 7 - 9% smaller (bench "template" group)
+//    LeafSize   nodes with more points than this are split; 8 gives
+//               about a quarter of the nodes, which saves far more
+//    MaxDepth   create() never builds more levels than this, and it
+//               sizes the explicit stack of the box->points query
+//    Payload    per leaf data, see NoPayload
+//
+//  Octree (int indices, one point per leaf) is the tree the game and
+//  the tools use.  PartOctree is the same tree with 16 bit indices, for
+//  meshes under 65536 vertices; only the bench builds one, since the
+//  lander collides as a single box.  The code is in Octree.cpp,
+//  which instantiates these; another set of parameters needs its own
+//  "template class" line there.
+//
+template <class Index, int LeafSize = 1, int MaxDepth = 32, class Payload = NoPayload>
+class OctreeT {
 public:
+	typedef TreeNodeT<Index, Payload> TreeNode;
 	
 	void create(const ofMesh & mesh, int numLevels);
 	void subdivide(const ofMesh & mesh, TreeNode & node, int numLevels, int level);
-	bool intersect(const Ray &, const TreeNode & node, TreeNode & nodeRtn);
-	bool intersect(const Box &, TreeNode & node, vector<Box> & boxListRtn);
-	bool intersect(const Box&, TreeNode& node, vector<TreeNode>& NodeListRtn); //added for final project
+
+	// the queries only read the tree (a lazy tree's expansion is locked,
+	// see expand()) and write only to the caller's output, so one built
+	// octree can serve any number of threads at once
+	//
+	bool intersect(const Ray &, const TreeNode & node, TreeNode & nodeRtn) const;
+	bool intersect(const Box &, const TreeNode & node, vector<Box> & boxListRtn) const;
+	bool intersect(const Box&, const TreeNode& node, vector<TreeNode>& NodeListRtn) const; //added for final project
+	bool intersect(const Box&, const TreeNode& node, vector<Index>& pointListRtn) const;
 	void draw(TreeNode & node, int numLevels, int level);
 	void draw(int numLevels, int level) {
 		draw(root, numLevels, level);
@@ -38,16 +125,40 @@ public:
 	void drawLeafNodes(TreeNode & node);
 	static void drawBox(const Box &box);
 	static Box meshBounds(const ofMesh &);
-	int getMeshPointsInBox(const ofMesh &mesh, const vector<int> & points, Box & box, vector<int> & pointsRtn);
-	int getMeshFacesInBox(const ofMesh &mesh, const vector<int> & faces, Box & box, vector<int> & facesRtn);
-	void subDivideBox8(const Box &b, vector<Box> & boxList);
+	OctreeMemory memory() const;
+	static size_t meshBytes(const ofMesh &);
+	int getMeshPointsInBox(const ofMesh &mesh, const vector<Index> & points, const Box & box, vector<Index> & pointsRtn) const;
+	int getMeshFacesInBox(const ofMesh &mesh, const vector<Index> & faces, const Box & box, vector<Index> & facesRtn) const;
+	void subDivideBox8(const Box &b, vector<Box> & boxList) const;
+
+	// build the children of a node a lazy create() left for later, once;
+	// every query calls it before it looks at a node's children.  Safe
+	// to call from several threads: one builds, the others wait for it
+	//
+	void expand(const TreeNode & node) const;
 
 	ofMesh mesh;
 	TreeNode root;
 	bool bUseFaces = false;
 
-	// debug;
+	// lazy construction: create() only builds "eagerLevels" levels, and
+	// deeper nodes get their children when a query first descends into
+	// them.  Once every part of the tree has been queried it is the same
+	// tree create() builds otherwise.
+	//
+	bool bLazy = false;
+	int eagerLevels = 4;
+	int levels = 0;             // numLevels of the last create()
+
+	// debug, counted by create() (and expand() for a lazy tree);
 	//
-	int strayVerts= 0;
+	int strayVerts= 0;  // points that fell in none of a node's child boxes
 	int numLeaf = 0;
-};
\ No newline at end of file
+
+private:
+	void leafBuilt(TreeNode & node);
+};
+
+typedef OctreeT<int> Octree;
+typedef Octree::TreeNode TreeNode;
+typedef OctreeT<uint16_t, 1, 16> PartOctree;
\ No newline at end of file
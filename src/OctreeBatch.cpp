@@ -0,0 +1,111 @@
+
+#include "OctreeBatch.h"
+
+void OctreeBatch::setup(const Octree *o, WorkPool *p) {
+	octree = o;
+	pool = p;
+}
+
+//  per thread state for a batch of n queries
+//
+void OctreeBatch::prepare(int n) {
+	int threads = pool->size();
+	if (queries.size() != threads) {
+		queries.assign(threads, CoherentQuery());
+		found.assign(threads, vector<int>());
+	}
+	for (CoherentQuery &q : queries) {
+		q.setup(octree);
+		q.bEnabled = false;     // from the root: the queries aren't one path
+	}
+	for (vector<int> &f : found) f.clear();
+	keys.resize(n);
+}
+
+//  10 bits of each coordinate inside the root box, interleaved
+//
+static uint32_t spread(uint32_t v) {
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+uint32_t OctreeBatch::morton(const Vector3 &p) const {
+	const Box &b = octree->root.box;
+	uint32_t code = 0;
+	for (int k = 0; k < 3; k++) {
+		float lo = b.parameters[0][k], size = b.parameters[1][k] - lo;
+		float f = size > 0 ? (p[k] - lo) / size : 0;
+		uint32_t cell = (uint32_t)(MIN(MAX(f, 0.0f), 1.0f) * 1023);
+		code |= spread(cell) << k;
+	}
+	return code;
+}
+
+//  keys hold (Morton code, query); run order is by code, or as given
+//
+void OctreeBatch::sortKeys() {
+	if (bSort) sort(keys.begin(), keys.end());
+	order.resize(keys.size());
+	for (int i = 0; i < keys.size(); i++) order[i] = bSort ? (uint32_t)keys[i] : i;
+}
+
+void OctreeBatch::intersect(const vector<Box> &boxes, vector<int> &pointsRtn, vector<int> &firstRtn) {
+	int n = boxes.size();
+	pointsRtn.clear();
+	firstRtn.assign(n + 1, 0);
+	if (octree == NULL || pool == NULL || n == 0) return;
+	prepare(n);
+	if (bSort) {
+		for (int i = 0; i < n; i++) keys[i] = (uint64_t)morton(boxes[i].center()) << 32 | i;
+	}
+	sortKeys();
+
+	// each thread appends to its own list and notes where each box went
+	//
+	owner.resize(n);
+	start.resize(n);
+	pool->parallelFor(n, chunk, [&](int first, int last, int t) {
+		vector<int> &out = found[t];
+		for (int k = first; k < last; k++) {
+			int i = order[k];
+			owner[i] = t;
+			start[i] = out.size();
+			octree->intersect(boxes[i], octree->root, out);
+			firstRtn[i + 1] = out.size() - start[i];
+		}
+	});
+
+	// then every box's points are copied to their place in caller order
+	//
+	for (int i = 0; i < n; i++) firstRtn[i + 1] += firstRtn[i];
+	pointsRtn.resize(firstRtn[n]);
+	pool->parallelFor(n, chunk, [&](int first, int last, int) {
+		for (int i = first; i < last; i++) {
+			const int *p = found[owner[i]].data() + start[i];
+			copy(p, p + (firstRtn[i + 1] - firstRtn[i]), pointsRtn.begin() + firstRtn[i]);
+		}
+	});
+}
+
+void OctreeBatch::intersectNearest(const vector<Ray> &rays, vector<int> &pointsRtn, vector<float> &tRtn) {
+	int n = rays.size();
+	pointsRtn.assign(n, -1);
+	tRtn.assign(n, 0);
+	if (octree == NULL || pool == NULL || n == 0) return;
+	prepare(n);
+	if (bSort) {
+		for (int i = 0; i < n; i++) keys[i] = (uint64_t)morton(rays[i].origin) << 32 | i;
+	}
+	sortKeys();
+
+	pool->parallelFor(n, chunk, [&](int first, int last, int t) {
+		CoherentQuery &q = queries[t];
+		for (int k = first; k < last; k++) {
+			int i = order[k];
+			q.intersectNearest(rays[i], pointsRtn[i], tRtn[i]);
+		}
+	});
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Octree.h"
+#include "CoherentQuery.h"
+#include "WorkPool.h"
+
+//  Large sets of octree queries at once, spread over a WorkPool.
+//
+//  For terrain analysis, Monte-Carlo landers and offline bakes, which
+//  ask thousands to millions of queries at a time.  The queries are
+//  first sorted by the Morton code of their position in the terrain's
+//  box (box center, ray origin), so queries handled one after another,
+//  and the chunks the pool hands out, touch nearby parts of the tree
+//  that are still in cache.  Results are written back in the caller's
+//  order, so they don't depend on sorting, chunk size or thread count.
+//
+//  "chunk" is how many queries a thread takes at a time: large enough
+//  to amortize the atomic that hands it out and to reuse the cached
+//  tree nodes of its neighbourhood, small enough that stealing can even
+//  out the work at the end.  The bench "parallel" group measures it.
+//
+class OctreeBatch {
+public:
+	OctreeBatch() { octree = NULL; pool = NULL; bSort = true; chunk = 64; }
+	void setup(const Octree *octree, WorkPool *pool);
+
+	// points of every leaf each box overlaps, exactly what
+	// Octree::intersect(box, root, points) returns: those of box i are
+	// pointsRtn[firstRtn[i]] up to pointsRtn[firstRtn[i + 1]]
+	//
+	void intersect(const vector<Box> &boxes, vector<int> &pointsRtn, vector<int> &firstRtn);
+
+	// point of the nearest one point leaf each ray crosses (t >= 0) and
+	// where the ray enters it, as CoherentQuery::intersectNearest(); -1
+	// and no t for a ray that hits none
+	//
+	void intersectNearest(const vector<Ray> &rays, vector<int> &pointsRtn, vector<float> &tRtn);
+
+	const Octree *octree;
+	WorkPool *pool;
+	bool bSort;             // Morton order, else the order given
+	int chunk;
+
+private:
+	void prepare(int n);
+	uint32_t morton(const Vector3 &p) const;
+	void sortKeys();
+
+	vector<uint64_t> keys;          // Morton code << 32 | query
+	vector<uint32_t> order;         // queries in the order they are run
+	vector<vector<int>> found;      // points found by each thread, before they are put in order
+	vector<int> owner, start;       // where each box's points are in "found"
+	vector<CoherentQuery> queries;  // one per thread
+};
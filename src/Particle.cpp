@@ -8,6 +8,7 @@ Particle::Particle() {
 	velocity.set(0, 0, 0);
 	acceleration.set(0, 0, 0);
 	position.set(0, 0, 0);
+	prevPosition.set(0, 0, 0);
 	//position.set(ofRandom(0, ofGetWindowWidth()), ofRandom(0, ofGetWindowHeight()), 0);
 	forces.set(0, 0, 0);
 	lifespan = 5;
@@ -16,6 +17,10 @@ Particle::Particle() {
 	damping = .99;
 	mass = 1;
 	color = ofColor::aquamarine;
+	rot = 0;
+	angularAccel = 0;
+	angularFor = 0;
+	angularVel = 0;
 }
 
 Particle::Particle(ofVec3f pos) {
@@ -25,6 +30,7 @@ Particle::Particle(ofVec3f pos) {
 	velocity.set(0, 0, 0);
 	acceleration.set(0, 0, 0);
 	position.set(pos);
+	prevPosition.set(pos);
 	forces.set(0, 0, 0);
 	lifespan = 5;
 	birthtime = 0;
@@ -32,27 +38,27 @@ Particle::Particle(ofVec3f pos) {
 	damping = .99;
 	mass = 1;
 	color = ofColor::aquamarine;
+	rot = 0;
+	angularAccel = 0;
+	angularFor = 0;
+	angularVel = 0;
 }
 
-void Particle::draw() {
+void Particle::draw(double now, float alpha) {
 //	ofSetColor(color);
-	ofSetColor(ofMap(age(), 0, lifespan, 255, 10), 0, 0);
-	ofDrawSphere(position, radius);
+	ofSetColor(ofMap(age(now), 0, lifespan, 255, 10), 0, 0);
+	ofDrawSphere(renderPosition(alpha), radius);
 }
 
 // write your own integrator here.. (hint: it's only 3 lines of code)
 //
-void Particle::integrate() {
+// dt is the fixed simulation step in seconds (see FixedTimestep)
+//
+void Particle::integrate(float dt) {
 
-	
-	// interval for this step
+	// remember where we were for render interpolation
 	//
-	float dt;
-	if (ofGetFrameRate() > 0) {
-		dt = 1.0 / ofGetFrameRate();
-	}
-	else dt = 1.0;
-	
+	prevPosition = position;
 
 	// update position based on velocity
 	//
@@ -65,9 +71,12 @@ void Particle::integrate() {
 	accel += (forces * (1.0 / mass));
 	velocity += accel * dt;
 
-	// add a little damping for good measure
+	// add a little damping for good measure.  "damping" is the factor
+	// per 1/60 s (the frame the game was tuned at), so the motion is the
+	// same at any step rate
 	//
-	velocity *= damping;
+	float decay = pow(damping, dt * 60);
+	velocity *= decay;
 	//cout << position << endl;
 
 	// clear forces on particle (they get re-added each step)
@@ -79,14 +88,21 @@ void Particle::integrate() {
 	float a = angularAccel;
 	a += (angularFor * 1.0 / mass);
 	angularVel += a * dt;
-	angularVel *= damping;
+	angularVel *= decay;
+
+}
 
+//  position to draw at, "alpha" of the way from the previous
+//  step to the current one
+//
+ofVec3f Particle::renderPosition(float alpha) const {
+	return prevPosition + (position - prevPosition) * alpha;
 }
 
-//  return age in seconds
+//  return age in seconds at simulation time "now"
 //
-float Particle::age() {
-	return (ofGetElapsedTimeMillis() - birthtime)/1000.0;
+float Particle::age(double now) const {
+	return now - birthtime;
 }
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ofMain.h"
+#include "SimClock.h"
 
 class ParticleForceField;
 
@@ -10,6 +11,7 @@ public:
 	Particle(ofVec3f pos);
 
 	ofVec3f position;
+	ofVec3f prevPosition;   // position at the start of the last step
 	ofVec3f velocity;
 	ofVec3f acceleration;
 	ofVec3f forces;
@@ -17,10 +19,11 @@ public:
 	float   mass;
 	float   lifespan;
 	float   radius;
-	float   birthtime;
-	void    integrate();
-	void    draw();
-	float   age();        // sec
+	double  birthtime;    // sec, simulation time (SimClock::now())
+	void    integrate(float dt);
+	ofVec3f renderPosition(float alpha) const;
+	void    draw(double now, float alpha = 1);
+	float   age(double now) const;        // sec
 	ofColor color;
 
 	//angular rotation
@@ -0,0 +1,27 @@
+
+#include "ParticleBatch.h"
+
+void ParticleBatch::pack(const ParticleSystem &sys) {
+	int n = sys.particles.size();
+	instances.resize(n);
+
+	float alpha = sys.renderAlpha;
+	for (int i = 0; i < n; i++) {
+		const Particle &p = sys.particles[i];
+		ParticleInstance &inst = instances[i];
+
+		ofVec3f pos = p.prevPosition + (p.position - p.prevPosition) * alpha;
+		inst.x = pos.x;
+		inst.y = pos.y;
+		inst.z = pos.z;
+		inst.radius = p.radius;
+
+		// same fade as Particle::draw(): red from 255 down to 10 over the lifespan
+		//
+		float red = ofMap(p.age(sys.time), 0, p.lifespan, 255, 10, true);
+		inst.r = red / 255.0f;
+		inst.g = 0;
+		inst.b = 0;
+		inst.a = 1;
+	}
+}
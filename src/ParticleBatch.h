@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ParticleSystem.h"
+
+//  One particle, as the instanced renderer sees it.  Floats only so the
+//  whole record can be bound as two vec4 vertex attributes.
+//
+struct ParticleInstance {
+	float x, y, z, radius;
+	float r, g, b, a;
+};
+
+//  CPU side of instanced particle drawing: packs a particle system into
+//  one flat instance array per frame (interpolated position, radius and
+//  the age based color Particle::draw() uses).  No GL here, so it can be
+//  benchmarked and checked without a GPU; ParticleRenderer draws it.
+//
+class ParticleBatch {
+public:
+	void pack(const ParticleSystem &sys);
+	int count() const { return instances.size(); }
+
+	vector<ParticleInstance> instances;
+};
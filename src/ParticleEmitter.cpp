@@ -27,7 +27,11 @@ ParticleEmitter::~ParticleEmitter() {
 	if (createdSys) delete sys;
 }
 
+// every emitter gets its own random stream, numbered in creation order
+//
 void ParticleEmitter::init() {
+	stream = Random::newStream();
+	rng.seed(0x5EED, stream);
 	rate = 1;
 	velocity = ofVec3f(0, 20, 0);
 	lifespan = 3;
@@ -35,11 +39,13 @@ void ParticleEmitter::init() {
 	oneShot = false;
 	fired = false;
 	lastSpawned = 0;
+	lastUpdate = 0;
 	radius = 1;
 	particleRadius = .1;
 	visible = true;
 	type = DirectionalEmitter;
 	groupSize = 1;
+	renderer = NULL;
 }
 
 
@@ -58,28 +64,29 @@ void ParticleEmitter::draw() {
 			break;
 		}
 	}
-	sys->draw();  
+	if (renderer) renderer->draw(*sys);
+	else sys->draw();
 }
 void ParticleEmitter::start() {
 	started = true;
-	lastSpawned = ofGetElapsedTimeMillis();
+	lastSpawned = lastUpdate;
 }
 
 void ParticleEmitter::stop() {
 	started = false;
 	fired = false;
 }
-void ParticleEmitter::update() {
+void ParticleEmitter::update(const SimClock &clock) {
 
-	float time = ofGetElapsedTimeMillis();
+	double time = clock.now();
+	lastUpdate = time;
 
 	if (oneShot && started) {
 		if (!fired) {
 
 			// spawn a new particle(s)
 			//
-			for (int i = 0; i < groupSize; i++)
-				spawn(time);
+			spawnBatch(groupSize, time);
 
 			lastSpawned = time;
 		}
@@ -87,24 +94,32 @@ void ParticleEmitter::update() {
 		stop();
 	}
 
-	else if (((time - lastSpawned) > (1000.0 / rate)) && started) {
+	else if (((time - lastSpawned) > (1.0 / rate)) && started) {
 
 		// spawn a new particle(s)
 		//
-		for (int i= 0; i < groupSize; i++)
-			spawn(time);
+		spawnBatch(groupSize, time);
 	
 		lastSpawned = time;
 	}
 
-	sys->update();
+	sys->update(clock);
 }
 
 // spawn a single particle.  time is current time of birth
 //
-void ParticleEmitter::spawn(float time) {
+void ParticleEmitter::spawn(double time) {
+	spawnBatch(1, time);
+}
+
+// spawn a group of "n" particles.  The new particles are created in place
+// at the end of the system's storage and their initial velocity and
+// position are generated for the whole group at once.
+//
+void ParticleEmitter::spawnBatch(int n, double time) {
+	if (n <= 0) return;
 
-	Particle particle;
+	Particle *p = sys->append(n);
 
 	// set initial velocity and position
 	// based on emitter type
@@ -112,27 +127,42 @@ void ParticleEmitter::spawn(float time) {
 	switch (type) {
 	case RadialEmitter:
 	{
-		ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1));
 		float speed = velocity.length();
-		particle.velocity = dir.getNormalized() * speed;
-		particle.position.set(position);
+		dirs.resize(n);
+		rng.fillOnSphere(&dirs[0], n, speed);
+		for (int i = 0; i < n; i++) {
+			p[i].velocity = dirs[i];
+			p[i].position = position;
+		}
 	}
 	break;
 	case SphereEmitter:
-		break;
+	{
+		// start on the surface of the emitter sphere, moving radially outward
+		//
+		float speed = velocity.length();
+		dirs.resize(n);
+		rng.fillOnSphere(&dirs[0], n, 1);
+		for (int i = 0; i < n; i++) {
+			p[i].velocity = dirs[i] * speed;
+			p[i].position = position + dirs[i] * radius;
+		}
+	}
+	break;
 	case DirectionalEmitter:
-		particle.velocity = velocity;
-		particle.position.set(position);
+		for (int i = 0; i < n; i++) {
+			p[i].velocity = velocity;
+			p[i].position = position;
+		}
 		break;
 	}
 
 	// other particle attributes
 	//
-	particle.lifespan = lifespan;
-	particle.birthtime = time;
-	particle.radius = particleRadius;
-
-	// add to system
-	//
-	sys->add(particle);
+	for (int i = 0; i < n; i++) {
+		p[i].prevPosition = p[i].position;
+		p[i].lifespan = lifespan;
+		p[i].birthtime = time;
+		p[i].radius = particleRadius;
+	}
 }
@@ -3,6 +3,8 @@
 
 #include "TransformObject.h"
 #include "ParticleSystem.h"
+#include "Random.h"
+#include "ParticleRenderer.h"
 
 typedef enum { DirectionalEmitter, RadialEmitter, SphereEmitter } EmitterType;
 
@@ -25,8 +27,10 @@ public:
 	void setEmitterType(EmitterType t) { type = t; }
 	void setGroupSize(int s) { groupSize = s; }
 	void setOneShot(bool s) { oneShot = s; }
-	void update();
-	void spawn(float time);
+	void setSeed(uint64_t seed) { rng.seed(seed, stream); }
+	void update(const SimClock &clock);
+	void spawn(double time);
+	void spawnBatch(int n, double time);
 	ParticleSystem *sys;
 	float rate;         // per sec
 	bool oneShot;
@@ -34,13 +38,18 @@ public:
 	ofVec3f velocity;
 	float lifespan;     // sec
 	bool started;
-	float lastSpawned;  // ms
+	double lastSpawned; // sec, simulation time
+	double lastUpdate;  // sec, simulation time
 	float particleRadius;
 	float radius;
 	bool visible;
 	int groupSize;      // number of particles to spawn in a group
 	bool createdSys;
 	EmitterType type;
+	Random rng;         // this emitter's own random stream
+	uint32_t stream;
+	vector<ofVec3f> dirs;  // scratch for bulk spawn
+	ParticleRenderer *renderer;  // if set, draw particles instanced
 
 	ofVec3f position;
 	void setPosition(ofVec3f p) {
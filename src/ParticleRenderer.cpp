@@ -0,0 +1,84 @@
+
+#include "ParticleRenderer.h"
+
+// scale and move the unit sphere per instance, flat color per instance
+//
+static const string vertexShader = R"(
+#version 120
+#extension GL_ARB_draw_instanced : enable
+attribute vec4 instance;        // xyz = center, w = radius
+attribute vec4 instanceColor;
+varying vec4 color;
+void main() {
+	vec4 p = vec4(gl_Vertex.xyz * instance.w + instance.xyz, 1.0);
+	gl_Position = gl_ModelViewProjectionMatrix * p;
+	color = instanceColor;
+}
+)";
+
+static const string fragmentShader = R"(
+#version 120
+varying vec4 color;
+void main() {
+	gl_FragColor = color;
+}
+)";
+
+ParticleRenderer::ParticleRenderer() {
+	capacity = 0;
+	bSetup = false;
+	bInstanced = false;
+}
+
+void ParticleRenderer::setup(int sphereResolution) {
+	sphere = ofMesh::sphere(1, sphereResolution);
+	bInstanced = shader.setupShaderFromSource(GL_VERTEX_SHADER, vertexShader) &&
+		shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragmentShader) &&
+		shader.linkProgram();
+	if (!bInstanced) cout << "ParticleRenderer: no instancing, drawing spheres one at a time" << endl;
+	capacity = 0;
+	bSetup = true;
+}
+
+void ParticleRenderer::draw(const ParticleSystem &sys) {
+	batch.pack(sys);
+	draw(batch);
+}
+
+void ParticleRenderer::draw(const ParticleBatch &b) {
+	int n = b.count();
+	if (n == 0) return;
+	if (!bSetup) setup();
+
+	if (!bInstanced) {
+		for (int i = 0; i < n; i++) {
+			const ParticleInstance &inst = b.instances[i];
+			ofSetColor(inst.r * 255, inst.g * 255, inst.b * 255, inst.a * 255);
+			ofDrawSphere(glm::vec3(inst.x, inst.y, inst.z), inst.radius);
+		}
+		return;
+	}
+
+	// upload the instances; grow the buffer geometrically and re-point
+	// the instance attributes at it, otherwise orphan and refill
+	//
+	const int stride = sizeof(ParticleInstance);
+	if (n > capacity) {
+		capacity = MAX(n, MAX(2 * capacity, 256));
+		instanceBuffer.allocate((size_t)capacity * stride, GL_STREAM_DRAW);
+
+		ofVbo &vbo = sphere.getVbo();
+		GLint loc = shader.getAttributeLocation("instance");
+		GLint colorLoc = shader.getAttributeLocation("instanceColor");
+		vbo.setAttributeBuffer(loc, instanceBuffer, 4, stride, offsetof(ParticleInstance, x));
+		vbo.setAttributeDivisor(loc, 1);
+		vbo.setAttributeBuffer(colorLoc, instanceBuffer, 4, stride, offsetof(ParticleInstance, r));
+		vbo.setAttributeDivisor(colorLoc, 1);
+	}
+	else instanceBuffer.setData((size_t)capacity * stride, NULL, GL_STREAM_DRAW);
+	instanceBuffer.updateData(0, (size_t)n * stride, &b.instances[0]);
+
+	shader.begin();
+	sphere.drawInstanced(OF_MESH_FILL, n);
+	shader.end();
+}
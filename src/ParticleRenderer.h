@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ParticleBatch.h"
+
+//  Draws a whole particle system with one instanced draw call: a unit
+//  sphere mesh, instanced once per particle from the ParticleBatch
+//  (position + radius, color).  Falls back to one ofDrawSphere() per
+//  particle if the instancing shader can't be built.
+//
+class ParticleRenderer {
+public:
+	ParticleRenderer();
+	void setup(int sphereResolution = 6);
+	void draw(const ParticleSystem &sys);
+	void draw(const ParticleBatch &batch);
+	bool isInstanced() const { return bInstanced; }
+
+	ParticleBatch batch;
+	ofVboMesh sphere;
+	ofBufferObject instanceBuffer;
+	ofShader shader;
+	int capacity;       // instances the buffer can hold
+	bool bSetup;
+	bool bInstanced;
+};
@@ -0,0 +1,53 @@
+
+#include "ParticleStaging.h"
+
+ParticleStaging::ParticleStaging() {
+	backend = NULL;
+	capacity = 0;
+	live = 0;
+	allocations = 0;
+	bytesUploaded = 0;
+}
+
+// stage the live particles for drawing
+//
+void ParticleStaging::update(const vector<Particle> &particles, float alpha) {
+	live = particles.size();
+	if (backend == NULL || live == 0) return;
+
+	// grow the store geometrically so steady state never reallocates,
+	// otherwise orphan it so the upload doesn't wait on the last draw
+	//
+	if (live > capacity) {
+		capacity = MAX(live, MAX(2 * capacity, 256));
+		backend->allocate(capacity, stride());
+		allocations++;
+	}
+	else backend->orphan();
+
+	if (positions.size() < live) positions.resize(capacity);
+	for (int i = 0; i < live; i++) positions[i] = particles[i].renderPosition(alpha);
+	backend->upload(&positions[0], live, stride());
+	bytesUploaded += (size_t)live * stride();
+}
+
+void VboStagingBackend::allocate(int capacity, int stride) {
+	bytes = (size_t)capacity * stride;
+	buffer.allocate(bytes, GL_STREAM_DRAW);
+
+	// sizes never change, so they are only written when the store grows
+	//
+	vector<ofVec3f> s(capacity, ofVec3f(pointSize));
+	sizes.setData(s.size() * sizeof(ofVec3f), &s[0], GL_STATIC_DRAW);
+
+	vbo.setVertexBuffer(buffer, 3, stride, 0);
+	vbo.setNormalBuffer(sizes, sizeof(ofVec3f), 0);
+}
+
+void VboStagingBackend::orphan() {
+	buffer.setData(bytes, NULL, GL_STREAM_DRAW);
+}
+
+void VboStagingBackend::upload(const void *data, int count, int stride) {
+	buffer.updateData(0, (size_t)count * stride, data);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Particle.h"
+
+//  Where staged particle data goes.  The GL backend streams into an
+//  ofBufferObject; anything else (a mock recording the calls, a file)
+//  can stand in for it so the staging logic runs without a GL context.
+//
+class StagingBackend {
+public:
+	virtual ~StagingBackend() {}
+	virtual void allocate(int capacity, int stride) = 0;       // (re)size the store, in particles
+	virtual void orphan() = 0;                                 // drop old contents, keep the size
+	virtual void upload(const void *data, int count, int stride) = 0; // write particles [0, count)
+};
+
+//  Render staging for a particle system.
+//
+//  Only what the shader reads goes to the GPU: the interpolated render
+//  position of each particle, packed 12 bytes apiece into one array that
+//  is reused from frame to frame (the whole Particle is about 100 bytes).
+//  The buffer only grows (geometrically); each frame it is orphaned and
+//  just the live range is uploaded.
+//
+class ParticleStaging {
+public:
+	ParticleStaging();
+	void setBackend(StagingBackend *b) { backend = b; capacity = 0; }
+	void update(const vector<Particle> &particles, float alpha = 1);   // alpha: see Particle::renderPosition()
+
+	int count() const { return live; }
+	static int stride() { return sizeof(ofVec3f); }
+
+	StagingBackend *backend;
+	int capacity;       // particles the backend can hold
+	int live;           // particles uploaded last update
+	vector<ofVec3f> positions;  // packed render positions, only grows
+
+	// counters
+	//
+	int allocations;
+	size_t bytesUploaded;
+};
+
+//  openFrameworks backend: one ofBufferObject bound as the vertex
+//  positions of "vbo", plus a constant point size in the normal
+//  attribute (read by the particle shader).
+//
+class VboStagingBackend : public StagingBackend {
+public:
+	VboStagingBackend(float pointSize = 50) { this->pointSize = pointSize; }
+	void allocate(int capacity, int stride);
+	void orphan();
+	void upload(const void *data, int count, int stride);
+
+	ofVbo vbo;
+	ofBufferObject buffer;
+	ofBufferObject sizes;
+	float pointSize;
+	size_t bytes = 0;
+};
@@ -5,6 +5,17 @@
 
 void ParticleSystem::add(const Particle &p) {
 	particles.push_back(p);
+	gridValid = false;
+}
+
+// grow the system by "n" particles in place and return a pointer to the
+// first new one, so emitters can fill a whole group without a push_back each
+//
+Particle * ParticleSystem::append(int n) {
+	int first = particles.size();
+	particles.resize(first + n);
+	gridValid = false;
+	return &particles[first];
 }
 
 void ParticleSystem::addForce(ParticleForce *f) {
@@ -13,6 +24,7 @@ void ParticleSystem::addForce(ParticleForce *f) {
 
 void ParticleSystem::remove(int i) {
 	particles.erase(particles.begin() + i);
+	gridValid = false;
 }
 
 void ParticleSystem::setLifespan(float l) {
@@ -27,7 +39,10 @@ void ParticleSystem::reset() {
 	}
 }
 
-void ParticleSystem::update() {
+void ParticleSystem::update(const SimClock &clock) {
+	time = clock.now();
+	gridValid = false;
+
 	// check if empty and just return
 	if (particles.size() == 0) return;
 
@@ -40,7 +55,7 @@ void ParticleSystem::update() {
 	//
 	/* //not deleting the player particle for this project. Manually remove if dead
 	while (p != particles.end()) {
-		if (p->lifespan != -1 && p->age() > p->lifespan) {
+		if (p->lifespan != -1 && p->age(time) > p->lifespan) {
 			tmp = particles.erase(p);
 			p = tmp;
 		}
@@ -71,19 +86,49 @@ void ParticleSystem::update() {
 	// integrate all the particles in the store
 	//
 	for (int i = 0; i < particles.size(); i++)
-		particles[i].integrate();
+		particles[i].integrate(clock.dt());
 
 }
 
-// remove all particlies within "dist" of point (not implemented as yet)
+// (re)build the spatial hash over the current particle positions
 //
-int ParticleSystem::removeNear(const ofVec3f & point, float dist) { return 0; }
+void ParticleSystem::buildGrid() {
+	grid.build(particles);
+	gridValid = true;
+}
+
+// indices of all particles within "dist" of point
+//
+int ParticleSystem::neighbors(const ofVec3f & point, float dist, vector<int> & indicesRtn) {
+	if (!gridValid) buildGrid();
+	return grid.neighbors(point, dist, indicesRtn);
+}
+
+// remove all particlies within "dist" of point, return number removed
+//
+int ParticleSystem::removeNear(const ofVec3f & point, float dist) {
+	nearby.clear();
+	int count = neighbors(point, dist, nearby);
+	if (count == 0) return 0;
+
+	// flag the particles, then compact the vector in one pass
+	//
+	dead.assign(particles.size(), false);
+	for (int i : nearby) dead[i] = true;
+	int j = 0;
+	for (int i = 0; i < particles.size(); i++) {
+		if (!dead[i]) particles[j++] = particles[i];
+	}
+	particles.resize(j);
+	gridValid = false;
+	return count;
+}
 
 //  draw the particle cloud
 //
 void ParticleSystem::draw() {
 	for (int i = 0; i < particles.size(); i++) {
-		particles[i].draw();
+		particles[i].draw(time, renderAlpha);
 	}
 }
 
@@ -106,6 +151,7 @@ void GravityForce::updateForce(Particle * particle) {
 TurbulenceForce::TurbulenceForce(const ofVec3f &min, const ofVec3f &max) {
 	tmin = min;
 	tmax = max;
+	rng.seed(0x5EED, Random::newStream());
 }
 
 void TurbulenceForce::updateForce(Particle * particle) {
@@ -113,9 +159,7 @@ void TurbulenceForce::updateForce(Particle * particle) {
 	// We are going to add a little "noise" to a particles
 	// forces to achieve a more natual look to the motion
 	//
-	particle->forces.x += ofRandom(tmin.x, tmax.x);
-	particle->forces.y += ofRandom(tmin.y, tmax.y);
-	particle->forces.z += ofRandom(tmin.z, tmax.z);
+	particle->forces += rng.inBox(tmin, tmax);
 }
 
 // Impulse Radial Force - this is a "one shot" force that
@@ -123,13 +167,16 @@ void TurbulenceForce::updateForce(Particle * particle) {
 //
 ImpulseRadialForce::ImpulseRadialForce(float magnitude) {
 	this->magnitude = magnitude;
+	this->height = 0;
 	applyOnce = true;
+	rng.seed(0x5EED, Random::newStream());
 }
 
 ImpulseRadialForce::ImpulseRadialForce(float magnitude, float height) {
 	this->magnitude = magnitude;
 	this->height = height;
 	applyOnce = true;
+	rng.seed(0x5EED, Random::newStream());
 }
 
 void ImpulseRadialForce::updateForce(Particle * particle) {
@@ -137,10 +184,9 @@ void ImpulseRadialForce::updateForce(Particle * particle) {
 	// we basically create a random direction for each particle
 	// the force is only added once after it is triggered.
 	//
-	ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1));
-	//ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1));
+	ofVec3f dir = rng.inBox(ofVec3f(-1, -1, -1), ofVec3f(1, 1, 1));
 	if(height != 0)
-		dir.y = height * ofRandom(-1, 1);
+		dir.y = height * rng.uniform(-1, 1);
 	//How to clamp y value?
 	particle->forces += dir.getNormalized() * magnitude;
 
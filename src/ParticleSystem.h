@@ -3,6 +3,8 @@
 
 #include "ofMain.h"
 #include "Particle.h"
+#include "Random.h"
+#include "SpatialHash.h"
 
 
 //  Pure Virtual Function Class - must be subclassed to create new forces.
@@ -12,21 +14,31 @@ protected:
 public:
 	bool applyOnce = false;
 	bool applied = false;
+	virtual ~ParticleForce() {}
 	virtual void updateForce(Particle *) = 0;
 };
 
 class ParticleSystem {
 public:
 	void add(const Particle &);
+	Particle * append(int n);
 	void addForce(ParticleForce *);
 	void remove(int);
-	void update();
+	void update(const SimClock &clock);
 	void setLifespan(float);
 	void reset();
 	int removeNear(const ofVec3f & point, float dist);
+	int neighbors(const ofVec3f & point, float dist, vector<int> & indicesRtn);
+	void buildGrid();
 	void draw();
 	vector<Particle> particles;
 	vector<ParticleForce *> forces;
+	float renderAlpha = 1;  // interpolation factor used by draw()
+	double time = 0;        // simulation time of the last update (sec)
+	SpatialHash grid;       // proximity queries, rebuilt on demand
+	bool gridValid = false;
+	vector<int> nearby;     // scratch for removeNear(), reused
+	vector<bool> dead;
 };
 
 
@@ -46,6 +58,7 @@ class TurbulenceForce : public ParticleForce {
 public:
 	TurbulenceForce(const ofVec3f & min, const ofVec3f &max);
 	void updateForce(Particle *);
+	Random rng;
 };
 
 class ThrustForce : public ParticleForce {
@@ -64,4 +77,5 @@ public:
 	ImpulseRadialForce(float magnitude, float height); 
 	void updateForce(Particle *);
 	void setHeight(float h);
+	Random rng;
 };
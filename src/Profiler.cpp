@@ -0,0 +1,209 @@
+
+#include "Profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <map>
+#include <memory>
+
+std::atomic<bool> Profiler::enabled(false);
+
+//  one thread's events.  Only the owning thread writes; "written" counts
+//  every event ever recorded, so the newest is at (written - 1) % size.
+//  The tid goes with the buffer, so threads that come and go reuse the
+//  same few tids and names.
+//
+class ProfileBuffer {
+public:
+	ProfileBuffer(uint32_t tid) : events(Profiler::bufferSize), written(0), bInUse(true), tid(tid) {}
+
+	vector<ProfileEvent> events;
+	std::atomic<uint64_t> written;
+	std::atomic<bool> bInUse;       // false once its thread has exited
+	uint32_t tid;
+};
+
+static mutex registryLock;
+static vector<unique_ptr<ProfileBuffer>> buffers;
+static vector<string> threadNames;  // by tid, one per buffer
+
+//  the calling thread's buffer, handed back for reuse when the thread
+//  exits (its events stay until overwritten)
+//
+class ProfileThread {
+public:
+	~ProfileThread() {
+		if (buffer) buffer->bInUse.store(false);
+	}
+	ProfileBuffer *buffer = NULL;
+};
+static thread_local ProfileThread thisThread;
+
+static ProfileThread &profileThread() {
+	if (thisThread.buffer == NULL) {
+		lock_guard<mutex> lock(registryLock);
+		for (auto &b : buffers) {
+			bool expected = false;
+			if (b->bInUse.compare_exchange_strong(expected, true)) {
+				thisThread.buffer = b.get();
+				break;
+			}
+		}
+		if (thisThread.buffer == NULL) {
+			buffers.push_back(unique_ptr<ProfileBuffer>(new ProfileBuffer(buffers.size())));
+			thisThread.buffer = buffers.back().get();
+			threadNames.push_back("");
+		}
+		uint32_t tid = thisThread.buffer->tid;
+		threadNames[tid] = "thread " + ofToString(tid);
+	}
+	return thisThread;
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end) {
+	ProfileThread &t = profileThread();
+	ProfileBuffer &b = *t.buffer;
+	uint64_t i = b.written.load(std::memory_order_relaxed);
+	ProfileEvent &e = b.events[i & (bufferSize - 1)];
+	e.name = name;
+	e.start = start;
+	e.dur = (uint32_t)MIN(end - start, (uint64_t)UINT32_MAX);
+	e.tid = b.tid;
+	b.written.store(i + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const string &name) {
+	ProfileThread &t = profileThread();
+	lock_guard<mutex> lock(registryLock);
+	threadNames[t.buffer->tid] = name;
+}
+
+//  drops everything recorded so far.  Meant for when no other thread
+//  is inside a zone, as are stats() and writeTrace(): events written
+//  while they run may come out torn.
+//
+void Profiler::clear() {
+	lock_guard<mutex> lock(registryLock);
+	for (auto &b : buffers) b->written.store(0);
+}
+
+//  copy of every buffered event, oldest first per thread
+//
+static void snapshot(vector<ProfileEvent> &out) {
+	lock_guard<mutex> lock(registryLock);
+	out.clear();
+	for (auto &b : buffers) {
+		uint64_t n = b->written.load(std::memory_order_acquire);
+		uint64_t count = MIN(n, (uint64_t)Profiler::bufferSize);
+		for (uint64_t i = n - count; i < n; i++) {
+			out.push_back(b->events[i & (Profiler::bufferSize - 1)]);
+		}
+	}
+}
+
+vector<ProfileStat> Profiler::stats(int window) {
+	vector<ProfileEvent> events;
+	snapshot(events);
+
+	// newest first, so each zone keeps its latest "window" events
+	//
+	sort(events.begin(), events.end(),
+		[](const ProfileEvent &a, const ProfileEvent &b) { return a.start > b.start; });
+
+	map<string, vector<uint32_t>> zones;
+	for (auto &e : events) {
+		vector<uint32_t> &d = zones[e.name];
+		if (d.size() < window) d.push_back(e.dur);
+	}
+
+	vector<ProfileStat> result;
+	for (auto &z : zones) {
+		vector<uint32_t> &d = z.second;
+		sort(d.begin(), d.end());
+		int n = d.size();
+		ProfileStat s;
+		s.name = z.first;
+		s.count = n;
+		s.p50 = d[(n - 1) / 2] / 1000.0;
+		s.p99 = d[(int)ceil((n - 1) * 0.99)] / 1000.0;
+		s.max = d[n - 1] / 1000.0;
+		result.push_back(s);
+	}
+	return result;
+}
+
+static string statLine(const string &name, const string &p50, const string &p99,
+	const string &max, const string &count) {
+	char line[128];
+	snprintf(line, sizeof(line), "%-20s %9s %9s %9s %6s", name.c_str(), p50.c_str(), p99.c_str(),
+		max.c_str(), count.c_str());
+	return line;
+}
+
+static vector<string> statTable(int window) {
+	vector<string> lines;
+	lines.push_back(statLine("zone", "p50 us", "p99 us", "max us", "n"));
+	for (auto &s : Profiler::stats(window)) {
+		lines.push_back(statLine(s.name, ofToString(s.p50, 1), ofToString(s.p99, 1),
+			ofToString(s.max, 1), ofToString(s.count)));
+	}
+	return lines;
+}
+
+void Profiler::print(ostream &os, int window) {
+	for (auto &line : statTable(window)) os << line << endl;
+}
+
+void Profiler::draw(float x, float y, int window) {
+	for (auto &line : statTable(window)) {
+		ofDrawBitmapString(line, x, y);
+		y += 14;
+	}
+}
+
+//  JSON string, quotes and backslashes escaped
+//
+static string jsonString(const string &s) {
+	string out = "\"";
+	for (char c : s) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+	return out + "\"";
+}
+
+//  complete ("X") events with times in microseconds from the first one,
+//  plus a thread_name record per thread
+//
+bool Profiler::writeTrace(const string &path) {
+	vector<ProfileEvent> events;
+	snapshot(events);
+	vector<string> names;
+	{
+		lock_guard<mutex> lock(registryLock);
+		names = threadNames;
+	}
+
+	ofstream out(path);
+	if (!out) return false;
+
+	uint64_t t0 = UINT64_MAX;
+	for (auto &e : events) t0 = MIN(t0, e.start);
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool bFirst = true;
+	for (int i = 0; i < names.size(); i++) {
+		out << (bFirst ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+			<< ",\"args\":{\"name\":" << jsonString(names[i]) << "}}";
+		bFirst = false;
+	}
+	out << fixed << setprecision(3);
+	for (auto &e : events) {
+		out << (bFirst ? "\n" : ",\n") << "{\"name\":" << jsonString(e.name)
+			<< ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+			<< ",\"ts\":" << (e.start - t0) / 1000.0 << ",\"dur\":" << e.dur / 1000.0 << "}";
+		bFirst = false;
+	}
+	out << "\n]}\n";
+	return out.good();
+}
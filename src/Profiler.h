@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <stdint.h>
+
+//  Scoped timers for finding where a frame goes.
+//
+//  PROFILE_ZONE("name") times the rest of the enclosing block.  Every
+//  thread writes its zones to a ring buffer of its own, so recording
+//  takes no lock and the newest events overwrite the oldest.  The
+//  profiler is off until enable() is called; while it is off a zone
+//  costs one relaxed load and a branch, and no buffers are allocated.
+//  Define LANDER_NO_PROFILE to compile the zones out altogether.
+//
+//  writeTrace() saves the buffers as Chrome trace events (open the file
+//  in chrome://tracing or ui.perfetto.dev).  stats() gives p50/p99 per
+//  zone over its most recent events, print() and draw() show them as
+//  a table on the console or on screen.
+//
+//  Zone names must be string literals (only the pointer is stored).
+//
+
+class ProfileEvent {
+public:
+	const char *name;
+	uint64_t start;         // ns, steady clock
+	uint32_t dur;           // ns
+	uint32_t tid;           // Profiler thread number
+};
+
+class ProfileStat {
+public:
+	string name;
+	int count;              // events the figures are taken over
+	double p50, p99, max;   // microseconds
+};
+
+class Profiler {
+public:
+	static void enable(bool on = true) { enabled.store(on, std::memory_order_relaxed); }
+	static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+	static uint64_t now() {
+		return chrono::duration_cast<chrono::nanoseconds>(
+			chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void record(const char *name, uint64_t start, uint64_t end);
+	static void setThreadName(const string &name);     // shown in the trace
+	static void clear();
+
+	// per zone figures over at most "window" most recent events, by name
+	//
+	static vector<ProfileStat> stats(int window = 240);
+	static void print(ostream &os, int window = 240);
+	static void draw(float x, float y, int window = 240);
+
+	static bool writeTrace(const string &path);
+
+	static const int bufferSize = 1 << 14;      // events per thread, power of 2
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+class ProfileZone {
+public:
+	ProfileZone(const char *name) {
+		this->name = name;
+		start = Profiler::isEnabled() ? Profiler::now() : 0;
+	}
+	~ProfileZone() {
+		if (start != 0) Profiler::record(name, start, Profiler::now());
+	}
+
+private:
+	const char *name;
+	uint64_t start;
+};
+
+#ifdef LANDER_NO_PROFILE
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE_JOIN2(a, b) a##b
+#define PROFILE_ZONE_JOIN(a, b) PROFILE_ZONE_JOIN2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_JOIN(profileZone, __LINE__)(name)
+#endif
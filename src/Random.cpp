@@ -0,0 +1,170 @@
+
+#include "Random.h"
+#include <atomic>
+
+// splitmix64 - used only to hash a seed and stream into generator state
+//
+static uint64_t splitmix64(uint64_t &x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+Random::Random(uint64_t seed, uint32_t stream) {
+	this->seed(seed, stream);
+}
+
+void Random::seed(uint64_t seed, uint32_t stream) {
+	// the stream's own starting point, hashed from both numbers
+	//
+	uint64_t x = seed;
+	uint64_t h = splitmix64(x);
+	x = h ^ stream;
+	uint64_t a = splitmix64(x);
+	uint64_t b = splitmix64(x);
+	s[0] = (uint32_t)a;
+	s[1] = (uint32_t)(a >> 32);
+	s[2] = (uint32_t)b;
+	s[3] = (uint32_t)(b >> 32) | 1;	// never all zero
+
+	// seed the bulk lanes from this stream
+	//
+	uint64_t y = ((uint64_t)s[0] << 32 | s[1]) ^ ((uint64_t)s[2] << 32 | s[3]);
+	for (int k = 0; k < 4; k++) {
+		uint64_t c = splitmix64(y);
+		uint64_t d = splitmix64(y);
+		lane[0][k] = (uint32_t)c;
+		lane[1][k] = (uint32_t)(c >> 32);
+		lane[2][k] = (uint32_t)d;
+		lane[3][k] = (uint32_t)(d >> 32) | 1;	// never all zero
+	}
+}
+
+uint32_t Random::newStream() {
+	static atomic<uint32_t> next(0);
+	return next++;
+}
+
+// equivalent to 2^64 calls to next(); used to create non-overlapping streams
+//
+void Random::jump() {
+	static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+	uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (int i = 0; i < 4; i++) {
+		for (int b = 0; b < 32; b++) {
+			if (JUMP[i] & (1u << b)) {
+				s0 ^= s[0];
+				s1 ^= s[1];
+				s2 ^= s[2];
+				s3 ^= s[3];
+			}
+			next();
+		}
+	}
+	s[0] = s0;
+	s[1] = s1;
+	s[2] = s2;
+	s[3] = s3;
+}
+
+ofVec3f Random::inBox(const ofVec3f &min, const ofVec3f &max) {
+	float x = uniform(min.x, max.x);
+	float y = uniform(min.y, max.y);
+	float z = uniform(min.z, max.z);
+	return ofVec3f(x, y, z);
+}
+
+// sin and cos of a random angle given in turns, t in [0, 1).  Branch free
+// polynomial (error < 1e-6) so the bulk loops below vectorize; the library
+// sin()/cos() calls dominated the cost of fillOnSphere().
+//
+static inline void sinCosTurns(float t, float &s, float &c) {
+	t = t - 0.5f;                                   // [-.5, .5) turn
+	float fold = (t > 0.25f) ? 0.5f - t : ((t < -0.25f) ? -0.5f - t : t);
+	float csign = (t > 0.25f || t < -0.25f) ? -1.0f : 1.0f;
+	float x = fold * (float)TWO_PI;                 // [-pi/2, pi/2]
+	float x2 = x * x;
+	s = x * (1 + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f +
+		x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+	c = csign * (1 + x2 * (-0.5f + x2 * (4.1666667e-2f + x2 * (-1.3888889e-3f +
+		x2 * (2.4801587e-5f + x2 * (-2.7557319e-7f + x2 * 2.0876757e-9f))))));
+}
+
+// uniformly distributed point on a sphere (no rejection loop)
+//
+ofVec3f Random::onSphere(float radius) {
+	float z = uniform(-1, 1);
+	float s, c;
+	sinCosTurns(uniform(), s, c);
+	float r = sqrt(MAX(0.0f, 1 - z * z)) * radius;
+	return ofVec3f(r * c, r * s, z * radius);
+}
+
+// advance the four lanes one step and return one float per lane in [0, 1)
+//
+void Random::nextLanes(float out[4]) {
+	for (int k = 0; k < 4; k++) {
+		const uint32_t result = lane[0][k] + lane[3][k];
+		const uint32_t t = lane[1][k] << 9;
+		lane[2][k] ^= lane[0][k];
+		lane[3][k] ^= lane[1][k];
+		lane[1][k] ^= lane[2][k];
+		lane[0][k] ^= lane[3][k];
+		lane[2][k] ^= t;
+		lane[3][k] = (lane[3][k] << 11) | (lane[3][k] >> 21);
+		out[k] = (result >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+void Random::fillUniform(float *out, int n, float min, float max) {
+	float u[4];
+	float range = max - min;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		nextLanes(u);
+		for (int k = 0; k < 4; k++)
+			out[i + k] = min + range * u[k];
+	}
+	if (i < n) {
+		nextLanes(u);
+		for (int k = 0; i < n; k++, i++)
+			out[i] = min + range * u[k];
+	}
+}
+
+void Random::fillInBox(ofVec3f *out, int n, const ofVec3f &min, const ofVec3f &max) {
+	float ux[4], uy[4], uz[4];
+	ofVec3f size = max - min;
+	for (int i = 0; i < n; i += 4) {
+		nextLanes(ux);
+		nextLanes(uy);
+		nextLanes(uz);
+		int count = MIN(4, n - i);
+		for (int k = 0; k < count; k++) {
+			out[i + k].set(min.x + size.x * ux[k], min.y + size.y * uy[k], min.z + size.z * uz[k]);
+		}
+	}
+}
+
+void Random::fillOnSphere(ofVec3f *out, int n, float radius) {
+	float uz[4], uphi[4];
+	for (int i = 0; i < n; i += 4) {
+		nextLanes(uz);
+		nextLanes(uphi);
+		float x[4], y[4], z[4];
+		for (int k = 0; k < 4; k++) {
+			float h = 2 * uz[k] - 1;
+			float r = sqrt(MAX(0.0f, 1 - h * h)) * radius;
+			float s, c;
+			sinCosTurns(uphi[k], s, c);
+			x[k] = r * c;
+			y[k] = r * s;
+			z[k] = h * radius;
+		}
+		int count = MIN(4, n - i);
+		for (int k = 0; k < count; k++)
+			out[i + k].set(x[k], y[k], z[k]);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Fast, seedable random number generator (xoshiro128+) for the particle
+//  hot loops.  ofRandom() goes through one global, non thread-safe generator;
+//  instead every emitter and random force owns its own Random so each one
+//  is an independent, reproducible stream.
+//
+//  A stream is selected by (seed, stream): both are hashed (splitmix64)
+//  into the generator state, so any stream is as cheap to start as the
+//  first.  Different streams are unrelated but not guaranteed disjoint;
+//  with 2^128 states an overlap within the runs made here is negligible.
+//  For sequences that provably never overlap, jump() a generator forward
+//  2^64 draws instead.  Use newStream() to number the objects that own a
+//  Random, or the thread or trial index.
+//
+class Random {
+public:
+	Random(uint64_t seed = 0x5EED, uint32_t stream = 0);
+	void seed(uint64_t seed, uint32_t stream = 0);
+	void jump();
+
+	// an unused stream number, counting up from 0 for the whole process
+	// (atomic, objects are created on several threads in batch runs)
+	//
+	static uint32_t newStream();
+
+	// next raw 32 bit value
+	//
+	uint32_t next() {
+		const uint32_t result = s[0] + s[3];
+		const uint32_t t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3] << 11) | (s[3] >> 21);
+		return result;
+	}
+
+	// uniform float in [0, 1) and [min, max)
+	//
+	float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+	float uniform(float min, float max) { return min + (max - min) * uniform(); }
+
+	ofVec3f inBox(const ofVec3f &min, const ofVec3f &max);
+	ofVec3f onSphere(float radius = 1);
+
+	// bulk versions - fill "n" values at a time.  These run four
+	// generator lanes side by side so the inner loops vectorize.
+	//
+	void fillUniform(float *out, int n, float min, float max);
+	void fillInBox(ofVec3f *out, int n, const ofVec3f &min, const ofVec3f &max);
+	void fillOnSphere(ofVec3f *out, int n, float radius = 1);
+
+private:
+	uint32_t s[4];
+	uint32_t lane[4][4];	// lane[word][lane], seeded from s in seed()
+	void nextLanes(float out[4]);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+//  Monotonic simulation time.
+//
+//  Time only moves when the simulation steps, one tick of dt() seconds
+//  at a time, so it is independent of the wall clock: a headless run can
+//  go as fast as the CPU allows and particle ages stay exact no matter
+//  how long the program has been up.  Timestamps (birth, last spawn)
+//  are taken from now() and stored as double seconds.
+//
+class SimClock {
+public:
+	SimClock(double step = 1.0 / 120) {
+		setStep(step);
+		ticks = 0;
+	}
+	void setStep(double seconds) { step = seconds; }
+	void tick() { ticks++; }
+	void reset() { ticks = 0; }
+
+	float dt() const { return (float)step; }
+	double now() const { return ticks * step; }     // sec
+
+	uint64_t ticks;
+private:
+	double step;
+};
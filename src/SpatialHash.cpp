@@ -0,0 +1,89 @@
+
+#include "SpatialHash.h"
+
+SpatialHash::SpatialHash(float cellSize, int tableSize) {
+	setCellSize(cellSize);
+
+	// round the table up to a power of 2 so the hash is just a mask
+	//
+	uint32_t size = 1;
+	while (size < (uint32_t)tableSize) size <<= 1;
+	mask = size - 1;
+	start.assign(size + 1, 0);
+}
+
+void SpatialHash::build(const vector<Particle> &particles) {
+	int n = particles.size();
+	int tableSize = mask + 1;
+
+	bucketOf.resize(n);
+	entries.resize(n);
+	sorted.resize(n);
+
+	// count particles per bucket (shifted by one for the prefix sum)
+	//
+	std::fill(start.begin(), start.end(), 0);
+	for (int i = 0; i < n; i++) {
+		uint32_t b = bucket(particles[i].position);
+		bucketOf[i] = b;
+		start[b + 1]++;
+	}
+
+	// prefix sum gives the first slot of each bucket
+	//
+	for (int b = 0; b < tableSize; b++)
+		start[b + 1] += start[b];
+
+	// scatter
+	//
+	fill.assign(start.begin(), start.end() - 1);
+	for (int i = 0; i < n; i++) {
+		int slot = fill[bucketOf[i]]++;
+		entries[slot] = i;
+		sorted[slot] = particles[i].position;
+	}
+}
+
+int SpatialHash::neighbors(const ofVec3f &p, float radius, vector<int> &indicesRtn) {
+	int count = 0;
+	float r2 = radius * radius;
+	int x0 = cell(p.x - radius), x1 = cell(p.x + radius);
+	int y0 = cell(p.y - radius), y1 = cell(p.y + radius);
+	int z0 = cell(p.z - radius), z1 = cell(p.z + radius);
+
+	// if the query covers more cells than there are buckets,
+	// just test every particle
+	//
+	int64_t numCells = (int64_t)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+	if (numCells > (int64_t)mask) {
+		for (int i = 0; i < (int)sorted.size(); i++) {
+			if (sorted[i].squareDistance(p) <= r2) {
+				indicesRtn.push_back(entries[i]);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	// different cells can hash to the same bucket, so collect the
+	// buckets first and visit each one only once
+	//
+	buckets.clear();
+	buckets.reserve(numCells);
+	for (int x = x0; x <= x1; x++)
+		for (int y = y0; y <= y1; y++)
+			for (int z = z0; z <= z1; z++)
+				buckets.push_back(bucket(x, y, z));
+	sort(buckets.begin(), buckets.end());
+	buckets.erase(unique(buckets.begin(), buckets.end()), buckets.end());
+
+	for (uint32_t b : buckets) {
+		for (int i = start[b]; i < start[b + 1]; i++) {
+			if (sorted[i].squareDistance(p) <= r2) {
+				indicesRtn.push_back(entries[i]);
+				count++;
+			}
+		}
+	}
+	return count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Particle.h"
+
+//  Uniform spatial hash over particle positions.
+//
+//  Space is cut into cubes of "cellSize" and each cube is hashed into a
+//  fixed size table.  build() is a counting sort: one pass to count the
+//  particles per bucket, a prefix sum, and one pass to scatter the particle
+//  indices (and a copy of their positions) into bucket order.  It does no
+//  allocation once the arrays have grown, so it is cheap to redo every step.
+//
+class SpatialHash {
+public:
+	SpatialHash(float cellSize = 1, int tableSize = 4096);
+	void setCellSize(float size) { cellSize = size; invCellSize = 1 / size; }
+	void build(const vector<Particle> &particles);
+
+	//  indices of the particles within "radius" of p, returns count found
+	//
+	int neighbors(const ofVec3f &p, float radius, vector<int> &indicesRtn);
+
+	int cell(float v) const { return (int)floor(v * invCellSize); }
+	uint32_t bucket(int ix, int iy, int iz) const {
+		return ((uint32_t)ix * 73856093u ^ (uint32_t)iy * 19349663u ^ (uint32_t)iz * 83492791u) & mask;
+	}
+	uint32_t bucket(const ofVec3f &p) const { return bucket(cell(p.x), cell(p.y), cell(p.z)); }
+
+	float cellSize;
+	vector<int> start;          // bucket b holds entries[start[b]] .. entries[start[b+1]-1]
+	vector<int> entries;        // particle indices, sorted by bucket
+	vector<ofVec3f> sorted;     // particle positions in the same order as entries
+
+private:
+	float invCellSize;
+	uint32_t mask;              // table size - 1 (table size is a power of 2)
+	vector<uint32_t> bucketOf;  // scratch for build()
+	vector<int> fill;
+	vector<uint32_t> buckets;   // scratch for neighbors()
+};
@@ -0,0 +1,117 @@
+
+#include "Terrain.h"
+#include "Random.h"
+#include <fstream>
+#include <sstream>
+
+bool Terrain::loadObj(const string &path, ofMesh &mesh) {
+	ifstream in(path);
+	if (!in) return false;
+
+	mesh.clear();
+	string line, tag;
+	vector<int> face;
+	while (getline(in, line)) {
+		istringstream ss(line);
+		if (!(ss >> tag)) continue;
+
+		if (tag == "v") {
+			float x = 0, y = 0, z = 0;
+			ss >> x >> y >> z;
+			mesh.addVertex(glm::vec3(x, y, z));
+		}
+		else if (tag == "f") {
+
+			// "f 1/2/3 4//6 -1 ..." - only the vertex index matters,
+			// negative indices count back from the last vertex
+			//
+			face.clear();
+			string ref;
+			while (ss >> ref) {
+				int i = atoi(ref.c_str());
+				if (i < 0) i += mesh.getNumVertices();
+				else i -= 1;
+				face.push_back(i);
+			}
+			for (int k = 2; k < face.size(); k++) {
+				mesh.addTriangle(face[0], face[k - 1], face[k]);
+			}
+		}
+	}
+	if (mesh.getNumVertices() == 0) return false;
+
+	computeNormals(mesh);
+	return true;
+}
+
+void Terrain::heightfield(ofMesh &mesh, float size, int res, float amplitude, uint64_t seed) {
+	mesh.clear();
+	res = MAX(res, 2);
+
+	// a few octaves of sine waves with random direction and phase
+	//
+	const int octaves = 4;
+	float kx[octaves], kz[octaves], phase[octaves];
+	Random rng(seed);
+	for (int o = 0; o < octaves; o++) {
+		float freq = (2 << o) * TWO_PI / size;
+		float angle = rng.uniform(0, TWO_PI);
+		kx[o] = cos(angle) * freq;
+		kz[o] = sin(angle) * freq;
+		phase[o] = rng.uniform(0, TWO_PI);
+	}
+
+	float step = size / (res - 1);
+	float half = size / 2;
+	float flat = 30;    // radius of the flat landing area
+	for (int j = 0; j < res; j++) {
+		for (int i = 0; i < res; i++) {
+			float x = -half + i * step;
+			float z = -half + j * step;
+
+			float h = 0;
+			for (int o = 0; o < octaves; o++) {
+				h += amplitude / (1 << o) * sin(kx[o] * x + kz[o] * z + phase[o]);
+			}
+			float r = sqrt(x * x + z * z);
+			float blend = ofClamp((r - flat) / flat, 0, 1);
+			mesh.addVertex(glm::vec3(x, h * blend, z));
+		}
+	}
+
+	for (int j = 0; j < res - 1; j++) {
+		for (int i = 0; i < res - 1; i++) {
+			int a = j * res + i;
+			int b = a + 1;
+			int c = a + res;
+			int d = c + 1;
+			mesh.addTriangle(a, c, b);
+			mesh.addTriangle(b, c, d);
+		}
+	}
+
+	computeNormals(mesh);
+}
+
+//  area weighted average of the face normals around each vertex
+//
+void Terrain::computeNormals(ofMesh &mesh) {
+	int n = mesh.getNumVertices();
+	vector<glm::vec3> normals(n, glm::vec3(0, 0, 0));
+	const vector<ofIndexType> &indices = mesh.getIndices();
+	const vector<glm::vec3> &verts = mesh.getVertices();
+
+	for (int i = 0; i + 2 < indices.size(); i += 3) {
+		int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		glm::vec3 fn = glm::cross(verts[b] - verts[a], verts[c] - verts[a]);
+		normals[a] += fn;
+		normals[b] += fn;
+		normals[c] += fn;
+	}
+
+	mesh.getNormals().clear();
+	for (int i = 0; i < n; i++) {
+		float len = glm::length(normals[i]);
+		mesh.addNormal(len > 0 ? normals[i] / len : glm::vec3(0, 1, 0));
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ofMain.h"
+
+//  Terrain meshes without ofxAssimpModelLoader, for programs that have no
+//  window (headless runs, benchmarks).  Both produce a triangle mesh with
+//  one normal per vertex, which is what Octree and LanderSim expect.
+//
+class Terrain {
+public:
+
+	//  load v/f records of a Wavefront .obj; polygons are fanned into
+	//  triangles and vertex normals are averaged from the faces
+	//
+	static bool loadObj(const string &path, ofMesh &mesh);
+
+	//  rolling hills on a res x res grid, "size" wide, centered on the
+	//  origin.  The center stays flat for the landing area.
+	//
+	static void heightfield(ofMesh &mesh, float size = 200, int res = 257,
+		float amplitude = 8, uint64_t seed = 1);
+
+	static void computeNormals(ofMesh &mesh);
+};
@@ -0,0 +1,110 @@
+
+#include "TerrainCollider.h"
+#include <cfloat>
+
+// pack signed cell coordinates (21 bits each) into one key
+//
+static uint64_t cellKey(int ix, int iy, int iz) {
+	const uint64_t bias = 1 << 20;
+	const uint64_t bits = (1 << 21) - 1;
+	return ((ix + bias) & bits) | (((iy + bias) & bits) << 21) | (((iz + bias) & bits) << 42);
+}
+
+TerrainCollider::TerrainCollider() {
+	octree = NULL;
+	cellSize = 1;
+}
+
+void TerrainCollider::setup(const Octree *o, float size) {
+	octree = o;
+	cellSize = size;
+	cells.clear();
+}
+
+// terrain vertices near cell (ix, iy, iz).  The cell is grown by half a
+// cell on every side so particles near a cell edge still see the
+// vertices just across it.  If that finds none and the cell is not
+// above the terrain, the search covers the terrain's full height over
+// the cell and widens until it finds some.
+//
+const vector<int> & TerrainCollider::cellPoints(int ix, int iy, int iz) {
+	uint64_t key = cellKey(ix, iy, iz);
+	auto it = cells.find(key);
+	if (it != cells.end()) return it->second;
+
+	vector<int> &points = cells[key];
+	float m = cellSize / 2;
+	Box box = Box(Vector3(ix * cellSize - m, iy * cellSize - m, iz * cellSize - m),
+		Vector3((ix + 1) * cellSize + m, (iy + 1) * cellSize + m, (iz + 1) * cellSize + m));
+	octree->intersect(box, octree->root, points);
+
+	const Box &bounds = octree->root.box;
+	if (points.empty() && iy * cellSize <= bounds.parameters[1].y()) {
+		float x0 = ix * cellSize, z0 = iz * cellSize;
+		float lo = bounds.parameters[0].y(), hi = bounds.parameters[1].y();
+		float reach = MAX(bounds.parameters[1].x() - bounds.parameters[0].x(), bounds.parameters[1].z() - bounds.parameters[0].z());
+		for (float r = m; points.empty() && r < 2 * reach; r *= 2) {
+			Box column(Vector3(x0 - r, lo, z0 - r), Vector3(x0 + cellSize + r, hi, z0 + cellSize + r));
+			octree->intersect(column, octree->root, points);
+		}
+	}
+	return points;
+}
+
+// push particles that have gone below the terrain back to the surface
+// and reflect their velocity, return the number of contacts
+//
+int TerrainCollider::collide(ParticleSystem &sys, float restitution) {
+	if (octree == NULL || sys.particles.size() == 0) return 0;
+
+	sys.grid.setCellSize(cellSize);
+	sys.buildGrid();
+
+	const ofMesh &mesh = octree->mesh;
+	bool hasNormals = mesh.getNumNormals() == mesh.getNumVertices();
+	int contacts = 0;
+
+	const vector<int> *points = NULL;
+	int lastX = 0, lastY = 0, lastZ = 0;
+
+	for (int s = 0; s < sys.grid.entries.size(); s++) {
+		Particle &p = sys.particles[sys.grid.entries[s]];
+		int ix = sys.grid.cell(p.position.x);
+		int iy = sys.grid.cell(p.position.y);
+		int iz = sys.grid.cell(p.position.z);
+		if (points == NULL || ix != lastX || iy != lastY || iz != lastZ) {
+			points = &cellPoints(ix, iy, iz);
+			lastX = ix;
+			lastY = iy;
+			lastZ = iz;
+		}
+		if (points->empty()) continue;   // no ground near this cell
+
+		// closest terrain vertex
+		//
+		int closest = -1;
+		float closestDist = FLT_MAX;
+		for (int k : *points) {
+			float d = p.position.squareDistance(mesh.getVertex(k));
+			if (d < closestDist) {
+				closestDist = d;
+				closest = k;
+			}
+		}
+		if (closest < 0) continue;
+
+		// below the tangent plane at that vertex?
+		//
+		ofVec3f v = mesh.getVertex(closest);
+		ofVec3f n = hasNormals ? ofVec3f(mesh.getNormal(closest)).getNormalized() : ofVec3f(0, 1, 0);
+		float depth = p.radius - (p.position - v).dot(n);
+		if (depth <= 0) continue;
+
+		p.position += n * depth;
+		float vn = p.velocity.dot(n);
+		if (vn < 0) p.velocity -= n * ((1 + restitution) * vn);
+		contacts++;
+	}
+	sys.gridValid = false;  // positions moved
+	return contacts;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Octree.h"
+#include "ParticleSystem.h"
+
+//  Cheap particle vs. terrain collision for exhaust and debris.
+//
+//  The terrain is seen through the same uniform cells as the particle
+//  SpatialHash.  The first time a particle lands in a cell, the octree
+//  is asked once for the leaf points near that cell and the list is
+//  cached; after that every particle in the cell is tested against those
+//  few vertices only, with no per-particle octree descent.  Particles are
+//  visited in hash order so consecutive particles share a cell lookup.
+//  A cell with no vertex near it (under a coarse mesh, or deep below the
+//  surface) takes the vertices of the terrain column around it instead,
+//  so a particle there still finds the surface above it.
+//
+class TerrainCollider {
+public:
+	TerrainCollider();
+	void setup(const Octree *octree, float cellSize = 1);
+	int collide(ParticleSystem &sys, float restitution = 0.5);
+	void clear() { cells.clear(); }
+
+	const vector<int> & cellPoints(int ix, int iy, int iz);
+
+	const Octree *octree;
+	float cellSize;
+	unordered_map<uint64_t, vector<int>> cells;  // cell key -> terrain vertex indices
+};
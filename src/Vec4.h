@@ -0,0 +1,113 @@
+#pragma once
+
+#include "vector3.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANDER_SSE 1
+#include <emmintrin.h>
+#include <string.h>
+#endif
+
+//  Four float SIMD register for the hot geometry loops.
+//
+//  Vector3 (Box, Ray), ofVec3f (particles) and glm::vec3 (mesh
+//  vertices) all store three packed floats, so any of them loads
+//  straight into a Vec4 with load3() / of() - no per component copy
+//  through a temporary of another type.  The fourth lane is 0 and is
+//  ignored by the comparisons.  Built with SSE2 when the compiler has
+//  it (always on x64), plain floats otherwise.
+//
+class Vec4 {
+public:
+	Vec4() {}
+	Vec4(float x, float y, float z, float w = 0) {
+#ifdef LANDER_SSE
+		v = _mm_set_ps(w, z, y, x);
+#else
+		v[0] = x; v[1] = y; v[2] = z; v[3] = w;
+#endif
+	}
+
+	// three packed floats, reads exactly 12 bytes.  x and y go through
+	// memcpy, not a double pointer, so the compiler sees float reads and
+	// can't move them past stores to the same floats (strict aliasing)
+	//
+	static Vec4 load3(const float *p) {
+#ifdef LANDER_SSE
+		double d;
+		memcpy(&d, p, sizeof(d));
+		__m128 xy = _mm_castpd_ps(_mm_set_sd(d));
+		return Vec4(_mm_movelh_ps(xy, _mm_load_ss(p + 2)));
+#else
+		return Vec4(p[0], p[1], p[2]);
+#endif
+	}
+	static Vec4 load3(const Vector3 &p) { return load3(p.data()); }
+
+	// ofVec3f, glm::vec3 or anything else with packed x, y, z members
+	//
+	template <class V> static Vec4 of(const V &p) { return load3(&p.x); }
+
+	void store3(float *p) const {
+#ifdef LANDER_SSE
+		double d = _mm_cvtsd_f64(_mm_castps_pd(v));
+		memcpy(p, &d, sizeof(d));
+		_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+#else
+		p[0] = v[0]; p[1] = v[1]; p[2] = v[2];
+#endif
+	}
+	template <class V> void store(V &p) const { store3(&p.x); }
+	Vector3 toVector3() const {
+		float f[3];
+		store3(f);
+		return Vector3(f[0], f[1], f[2]);
+	}
+
+#ifdef LANDER_SSE
+	explicit Vec4(__m128 m) : v(m) {}
+
+	Vec4 operator+(const Vec4 &o) const { return Vec4(_mm_add_ps(v, o.v)); }
+	Vec4 operator-(const Vec4 &o) const { return Vec4(_mm_sub_ps(v, o.v)); }
+	Vec4 operator*(const Vec4 &o) const { return Vec4(_mm_mul_ps(v, o.v)); }
+	Vec4 operator*(float s) const { return Vec4(_mm_mul_ps(v, _mm_set1_ps(s))); }
+	static Vec4 min(const Vec4 &a, const Vec4 &b) { return Vec4(_mm_min_ps(a.v, b.v)); }
+	static Vec4 max(const Vec4 &a, const Vec4 &b) { return Vec4(_mm_max_ps(a.v, b.v)); }
+
+	// bit i set if lane i of a <= lane i of b
+	//
+	static int lessEqual(const Vec4 &a, const Vec4 &b) { return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+
+	__m128 v;
+#else
+	Vec4 operator+(const Vec4 &o) const { return Vec4(v[0] + o.v[0], v[1] + o.v[1], v[2] + o.v[2], v[3] + o.v[3]); }
+	Vec4 operator-(const Vec4 &o) const { return Vec4(v[0] - o.v[0], v[1] - o.v[1], v[2] - o.v[2], v[3] - o.v[3]); }
+	Vec4 operator*(const Vec4 &o) const { return Vec4(v[0] * o.v[0], v[1] * o.v[1], v[2] * o.v[2], v[3] * o.v[3]); }
+	Vec4 operator*(float s) const { return Vec4(v[0] * s, v[1] * s, v[2] * s, v[3] * s); }
+	static Vec4 min(const Vec4 &a, const Vec4 &b) {
+		Vec4 r;
+		for (int i = 0; i < 4; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+		return r;
+	}
+	static Vec4 max(const Vec4 &a, const Vec4 &b) {
+		Vec4 r;
+		for (int i = 0; i < 4; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+		return r;
+	}
+	static int lessEqual(const Vec4 &a, const Vec4 &b) {
+		int m = 0;
+		for (int i = 0; i < 4; i++) m |= (a.v[i] <= b.v[i]) << i;
+		return m;
+	}
+
+	float v[4];
+#endif
+
+	// true if a <= b in x, y and z
+	//
+	static bool allLessEqual3(const Vec4 &a, const Vec4 &b) { return (lessEqual(a, b) & 7) == 7; }
+};
+
+//  Vector3 from any packed x, y, z type (ofVec3f, glm::vec3)
+//
+template <class V> inline Vector3 toVector3(const V &p) { return Vector3(p.x, p.y, p.z); }
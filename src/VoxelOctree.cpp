@@ -0,0 +1,283 @@
+
+#include "VoxelOctree.h"
+#include "Vec4.h"
+#include <climits>
+
+static VoxelNode node(int kind, uint32_t index = 0) {
+	VoxelNode n;
+	n.info = index << 2 | kind;
+	return n;
+}
+
+void VoxelOctree::build(const ofMesh &mesh, int numLevels) {
+	levels = MIN(MAX(numLevels, 2), 12);
+	int n = side();
+	nodes.clear();
+	bricks.clear();
+	int nv = mesh.getNumVertices();
+	if (nv == 0) return;
+
+	// the cube: the mesh's bounds, grown a little so no vertex sits on its
+	// max faces
+	//
+	const glm::vec3 *verts = mesh.getVerticesPointer();
+	Vec4 lo = Vec4::of(verts[0]), hi = lo;
+	for (int i = 1; i < nv; i++) {
+		Vec4 v = Vec4::of(verts[i]);
+		lo = Vec4::min(lo, v);
+		hi = Vec4::max(hi, v);
+	}
+	Vector3 size = hi.toVector3() - lo.toVector3();
+	float edge = MAX(size.x(), MAX(size.y(), size.z()));
+	edge = edge * 1.001f + 0.001f;
+	origin = lo.toVector3() - Vector3(edge, edge, edge) * 0.0002f;
+	voxel = edge * 1.0004f / n;
+
+	// highest occupied voxel of each column: every triangle raises the
+	// columns under its bounds to the voxel of its highest corner
+	//
+	vector<int> tops(n * n, -1);
+	int nt = mesh.getNumIndices() > 0 ? mesh.getNumIndices() / 3 : nv / 3;
+	for (int t = 0; t < nt; t++) {
+		int c[3][3];
+		for (int k = 0; k < 3; k++) {
+			int v = mesh.getNumIndices() > 0 ? mesh.getIndex(t * 3 + k) : t * 3 + k;
+			cellOf(toVector3(verts[v]), c[k]);
+		}
+		int x0 = MIN(c[0][0], MIN(c[1][0], c[2][0])), x1 = MAX(c[0][0], MAX(c[1][0], c[2][0]));
+		int z0 = MIN(c[0][2], MIN(c[1][2], c[2][2])), z1 = MAX(c[0][2], MAX(c[1][2], c[2][2]));
+		int top = MAX(c[0][1], MAX(c[1][1], c[2][1]));
+		for (int z = z0; z <= z1; z++) {
+			for (int x = x0; x <= x1; x++) tops[x + z * n] = MAX(tops[x + z * n], top);
+		}
+	}
+
+	nodes.push_back(node(VoxelNode::Empty));
+	fill(0, 0, 0, 0, n, tops);
+}
+
+//  voxel of a point, clamped to the cube
+//
+void VoxelOctree::cellOf(const Vector3 &p, int c[3]) const {
+	int n = side();
+	for (int k = 0; k < 3; k++) {
+		int i = (int)floor(MIN(MAX((p[k] - origin[k]) / voxel, 0.0f), (float)n));
+		c[k] = MIN(i, n - 1);
+	}
+}
+
+//  nodes[index] for the cube of "size" voxels at x, y, z
+//
+void VoxelOctree::fill(uint32_t index, int x, int y, int z, int size, const vector<int> &tops) {
+	int n = side();
+	int lowest = INT_MAX, highest = -1;
+	for (int k = z; k < z + size; k++) {
+		for (int i = x; i < x + size; i++) {
+			int t = tops[i + k * n];
+			lowest = MIN(lowest, t);
+			highest = MAX(highest, t);
+		}
+	}
+	if (y > highest) {
+		nodes[index] = node(VoxelNode::Empty);
+		return;
+	}
+	if (y + size - 1 <= lowest) {
+		nodes[index] = node(VoxelNode::Solid);
+		return;
+	}
+
+	if (size == 4) {
+		uint64_t bits = 0;
+		for (int k = 0; k < 4; k++) {
+			for (int j = 0; j < 4; j++) {
+				for (int i = 0; i < 4; i++) {
+					if (y + j <= tops[x + i + (z + k) * n]) bits |= 1ull << (i + 4 * j + 16 * k);
+				}
+			}
+		}
+		nodes[index] = node(VoxelNode::Mixed, bricks.size());
+		bricks.push_back(bits);
+		return;
+	}
+
+	uint32_t first = nodes.size();
+	nodes[index] = node(VoxelNode::Mixed, first);
+	nodes.resize(first + 8);
+	int half = size / 2;
+	for (int o = 0; o < 8; o++) {
+		fill(first + o, x + (o & 1 ? half : 0), y + (o & 2 ? half : 0), z + (o & 4 ? half : 0), half, tops);
+	}
+}
+
+bool VoxelOctree::occupied(const Vector3 &p) const {
+	if (nodes.empty()) return false;
+	int c[3];
+	for (int k = 0; k < 3; k++) {
+		float f = (p[k] - origin[k]) / voxel;
+		if (!(f >= 0 && f < side())) return false;
+		c[k] = (int)f;
+	}
+
+	uint32_t index = 0;
+	int half = side() / 2;
+	for (;;) {
+		VoxelNode nd = nodes[index];
+		if (nd.kind() != VoxelNode::Mixed) return nd.kind() == VoxelNode::Solid;
+		if (half == 2) {
+			int bit = (c[0] & 3) + 4 * (c[1] & 3) + 16 * (c[2] & 3);
+			return bricks[nd.index()] >> bit & 1;
+		}
+		int o = (c[0] & half ? 1 : 0) | (c[1] & half ? 2 : 0) | (c[2] & half ? 4 : 0);
+		index = nd.index() + o;
+		half /= 2;
+	}
+}
+
+bool VoxelOctree::empty(const Box &box) const {
+	if (nodes.empty()) return true;
+	int n = side();
+	int lo[3], hi[3];
+	for (int k = 0; k < 3; k++) {
+		float a = (box.parameters[0][k] - origin[k]) / voxel;
+		float b = (box.parameters[1][k] - origin[k]) / voxel;
+		if (b < 0 || a >= n) return true;
+		lo[k] = (int)floor(MAX(a, 0.0f));
+		hi[k] = MIN((int)floor(MIN(b, (float)n)), n - 1);
+	}
+	return emptyIn(0, 0, 0, 0, n, lo, hi);
+}
+
+//  4 bits, those of lo - hi within 0 - 3
+//
+static int span4(int lo, int hi) {
+	lo = MAX(lo, 0);
+	hi = MIN(hi, 3);
+	return lo > hi ? 0 : ((2 << hi) - 1) & ~((1 << lo) - 1);
+}
+
+bool VoxelOctree::emptyIn(uint32_t index, int x, int y, int z, int size, const int lo[3], const int hi[3]) const {
+	if (hi[0] < x || lo[0] >= x + size || hi[1] < y || lo[1] >= y + size || hi[2] < z || lo[2] >= z + size) return true;
+	VoxelNode nd = nodes[index];
+	if (nd.kind() == VoxelNode::Empty) return true;
+	if (nd.kind() == VoxelNode::Solid) return false;
+
+	if (size == 4) {
+		uint64_t row = span4(lo[0] - x, hi[0] - x);
+		int ys = span4(lo[1] - y, hi[1] - y), zs = span4(lo[2] - z, hi[2] - z);
+		uint64_t mask = 0;
+		for (int k = 0; k < 4; k++) {
+			if (!(zs >> k & 1)) continue;
+			for (int j = 0; j < 4; j++) {
+				if (ys >> j & 1) mask |= row << (4 * j + 16 * k);
+			}
+		}
+		return (bricks[nd.index()] & mask) == 0;
+	}
+
+	int half = size / 2;
+	for (int o = 0; o < 8; o++) {
+		if (!emptyIn(nd.index() + o, x + (o & 1 ? half : 0), y + (o & 2 ? half : 0), z + (o & 4 ? half : 0), half, lo, hi)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//  Works in voxel cells, not points, so it can't get stuck on a face:
+//  leaving a node or a brick moves the cell across that face exactly,
+//  and only the other two coordinates come from the ray, clamped to the
+//  node that was left.
+//
+bool VoxelOctree::intersect(const Ray &ray, float &tRtn, float t0, float t1) const {
+	if (nodes.empty()) return false;
+	int n = side();
+	const Vector3 &o = ray.origin, &d = ray.direction;
+
+	// the part of the ray inside the cube (a 0 / 0 from a ray along a face
+	// is NaN, which fmax / fmin pass over)
+	//
+	float tIn = t0, tOut = t1;
+	for (int k = 0; k < 3; k++) {
+		float a = (origin[k] - o[k]) * ray.inv_direction[k];
+		float b = (origin[k] + n * voxel - o[k]) * ray.inv_direction[k];
+		tIn = fmax(tIn, fmin(a, b));
+		tOut = fmin(tOut, fmax(a, b));
+	}
+	if (tIn > tOut) return false;
+
+	float t = tIn;
+	int step[3], c[3];
+	for (int k = 0; k < 3; k++) step[k] = d[k] > 0 ? 1 : -1;
+	cellOf(o + d * t, c);
+
+	for (;;) {
+		// the node holding cell c
+		//
+		uint32_t index = 0;
+		int x[3] = { 0, 0, 0 };
+		int size = n;
+		while (nodes[index].kind() == VoxelNode::Mixed && size > 4) {
+			size /= 2;
+			int oct = 0;
+			for (int k = 0; k < 3; k++) {
+				if (c[k] >= x[k] + size) {
+					x[k] += size;
+					oct |= 1 << k;
+				}
+			}
+			index = nodes[index].index() + oct;
+		}
+		VoxelNode nd = nodes[index];
+		if (nd.kind() == VoxelNode::Solid) {
+			tRtn = t;
+			return true;
+		}
+
+		int axis = 0;
+		if (nd.kind() == VoxelNode::Mixed) {
+			// a brick: voxel by voxel until a set bit or out of the brick
+			//
+			uint64_t bits = bricks[nd.index()];
+			float tMax[3], tDelta[3];
+			for (int k = 0; k < 3; k++) {
+				float next = origin[k] + (c[k] + (step[k] > 0)) * voxel;
+				tMax[k] = d[k] != 0 ? (next - o[k]) * ray.inv_direction[k] : FLT_MAX;
+				tDelta[k] = d[k] != 0 ? voxel * fabs(ray.inv_direction[k]) : FLT_MAX;
+			}
+			for (;;) {
+				if (bits >> ((c[0] - x[0]) + 4 * (c[1] - x[1]) + 16 * (c[2] - x[2])) & 1) {
+					tRtn = t;
+					return true;
+				}
+				axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+				t = MAX(t, tMax[axis]);
+				c[axis] += step[axis];
+				tMax[axis] += tDelta[axis];
+				if (t > tOut) return false;
+				if (c[axis] < x[axis] || c[axis] >= x[axis] + 4) break;
+			}
+		}
+		else {
+			// empty: straight to where the ray leaves the node
+			//
+			float tExit = FLT_MAX;
+			for (int k = 0; k < 3; k++) {
+				if (d[k] == 0) continue;
+				float face = origin[k] + (x[k] + (step[k] > 0 ? size : 0)) * voxel;
+				float tk = (face - o[k]) * ray.inv_direction[k];
+				if (tk < tExit) {
+					tExit = tk;
+					axis = k;
+				}
+			}
+			t = MAX(t, tExit);
+			if (t > tOut) return false;
+			int exit = step[axis] > 0 ? x[axis] + size : x[axis] - 1;
+			cellOf(o + d * t, c);
+			for (int k = 0; k < 3; k++) c[k] = MIN(MAX(c[k], x[k]), x[k] + size - 1);
+			c[axis] = exit;
+		}
+		if (c[axis] < 0 || c[axis] >= n) return false;
+	}
+}
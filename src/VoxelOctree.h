@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ofMain.h"
+#include "box.h"
+#include "ray.h"
+#include <cfloat>
+
+//  One node of a VoxelOctree, 4 bytes.
+//
+class VoxelNode {
+public:
+	enum Kind { Empty, Solid, Mixed };
+
+	uint32_t info;      // kind in the low 2 bits; Mixed: index of the first child, or of the brick, above
+
+	int kind() const { return info & 3; }
+	uint32_t index() const { return info >> 2; }
+};
+
+//  Which parts of space the terrain fills, as a sparse voxel octree.
+//
+//  build() puts a cube of (1 << levels)^3 voxels around the mesh and
+//  marks a voxel occupied if it is under or on the terrain surface:
+//  for each column of voxels, everything up to the highest triangle
+//  over it.  That is inside the terrain for a height field (the moon
+//  and the procedural terrain); under an overhang it fills the space
+//  below too.  Either way every triangle lies in occupied voxels, so a
+//  box that is all free space can't touch the terrain, which is what
+//  makes empty() a broad phase in front of the exact triangle tests.
+//
+//  A node whose cube is all free or all occupied is one Empty or Solid
+//  node with no children; the rest split into 8 down to 4 x 4 x 4
+//  voxels, stored as one 64 bit brick.  Queries:
+//
+//    occupied(point)  one walk down the tree
+//    empty(box)       stops at the first Solid node or brick bit
+//    intersect(ray)   skips whole Empty nodes, steps voxel by voxel
+//                     (3D DDA) only through the bricks it crosses
+//
+//  Everything outside the cube is free space.
+//
+class VoxelOctree {
+public:
+	VoxelOctree() { levels = 0; voxel = 0; }
+
+	// voxelize "mesh" with 2 <= levels <= 12 (4 to 4096 voxels a side)
+	//
+	void build(const ofMesh &mesh, int levels = 8);
+
+	bool occupied(const Vector3 &p) const;
+
+	// true if no occupied voxel overlaps the box (voxels it touches count)
+	//
+	bool empty(const Box &box) const;
+
+	// t at which the ray enters the first occupied voxel between t0 and
+	// t1 (t0 if it starts in one); false if it meets none
+	//
+	bool intersect(const Ray &ray, float &tRtn, float t0 = 0, float t1 = FLT_MAX) const;
+
+	int side() const { return 1 << levels; }        // voxels along each edge of the cube
+	size_t bytes() const { return nodes.size() * sizeof(VoxelNode) + bricks.size() * sizeof(uint64_t); }
+
+	vector<VoxelNode> nodes;    // root first, the 8 children of a node together, octant bits x 1, y 2, z 4
+	vector<uint64_t> bricks;    // 4 x 4 x 4 voxels, bit x + 4 y + 16 z
+	Vector3 origin;             // min corner of the cube
+	float voxel;                // voxel edge length
+	int levels;
+
+private:
+	void fill(uint32_t index, int x, int y, int z, int size, const vector<int> &tops);
+	bool emptyIn(uint32_t index, int x, int y, int z, int size, const int lo[3], const int hi[3]) const;
+	void cellOf(const Vector3 &p, int c[3]) const;
+};
@@ -0,0 +1,121 @@
+
+#include "WorkPool.h"
+
+static uint64_t pack(int first, int last) { return (uint64_t)(uint32_t)first << 32 | (uint32_t)last; }
+static int firstOf(uint64_t span) { return (int)(span >> 32); }
+static int lastOf(uint64_t span) { return (int)(uint32_t)span; }
+
+WorkPool::WorkPool(int threads) : steals(0) {
+	if (threads <= 0) threads = MAX((int)std::thread::hardware_concurrency(), 1);
+	ranges.reset(new Range[threads]);
+	for (int t = 0; t < threads; t++) ranges[t].span.store(0, std::memory_order_relaxed);
+	job = NULL;
+	chunk = 1;
+	generation = 0;
+	running = 0;
+	bQuit = false;
+	for (int t = 1; t < threads; t++) workers.push_back(std::thread(&WorkPool::loop, this, t));
+}
+
+WorkPool::~WorkPool() {
+	{
+		std::lock_guard<std::mutex> l(lock);
+		bQuit = true;
+	}
+	started.notify_all();
+	for (auto &w : workers) w.join();
+}
+
+void WorkPool::run(int count, int chunkSize, const std::function<void(int, int, int)> &f) {
+	if (count <= 0) return;
+	int n = size();
+	{
+		std::lock_guard<std::mutex> l(lock);
+		job = &f;
+		chunk = MAX(chunkSize, 1);
+		for (int t = 0; t < n; t++) {
+			ranges[t].span.store(pack((long)count * t / n, (long)count * (t + 1) / n), std::memory_order_relaxed);
+		}
+		running = n - 1;
+		generation++;
+	}
+	started.notify_all();
+	work(0);
+
+	std::unique_lock<std::mutex> l(lock);
+	finished.wait(l, [&]() { return running == 0; });
+	job = NULL;
+}
+
+//  pool threads: sleep until the next run() or the destructor
+//
+void WorkPool::loop(int thread) {
+	uint64_t seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> l(lock);
+			started.wait(l, [&]() { return bQuit || generation != seen; });
+			if (bQuit) return;
+			seen = generation;
+		}
+		work(thread);
+		std::lock_guard<std::mutex> l(lock);
+		if (--running == 0) finished.notify_one();
+	}
+}
+
+//  own range first, then other threads', until there is nothing left
+//  anywhere.  Work only ever shrinks, so once a thread finds every
+//  range empty the rest is in the hands of the threads running it.
+//
+void WorkPool::work(int thread) {
+	int first, last;
+	while (take(thread, first, last) || steal(thread, first, last)) {
+		(*job)(first, last, thread);
+	}
+}
+
+//  the next "chunk" indices off the front of our own range
+//
+bool WorkPool::take(int thread, int &first, int &last) {
+	std::atomic<uint64_t> &span = ranges[thread].span;
+	uint64_t s = span.load(std::memory_order_relaxed);
+	for (;;) {
+		first = firstOf(s);
+		last = lastOf(s);
+		if (first >= last) return false;
+		int end = MIN(first + chunk, last);
+		if (span.compare_exchange_weak(s, pack(end, last), std::memory_order_relaxed)) {
+			last = end;
+			return true;
+		}
+	}
+}
+
+//  the back half of another thread's range (all of it if it is down to
+//  a chunk); the first chunk is returned, the rest becomes our range
+//
+bool WorkPool::steal(int thread, int &first, int &last) {
+	int n = size();
+	bool bRetry = true;
+	while (bRetry) {
+		bRetry = false;
+		for (int k = 1; k < n; k++) {
+			std::atomic<uint64_t> &span = ranges[(thread + k) % n].span;
+			uint64_t s = span.load(std::memory_order_relaxed);
+			int f = firstOf(s), l = lastOf(s);
+			if (f >= l) continue;
+			int mid = l - f > chunk ? f + (l - f) / 2 : f;
+			if (!span.compare_exchange_strong(s, pack(f, mid), std::memory_order_relaxed)) {
+				bRetry = true;      // it moved on, look again
+				continue;
+			}
+			steals.fetch_add(1, std::memory_order_relaxed);
+			first = mid;
+			last = MIN(mid + chunk, l);
+			ranges[thread].span.store(pack(last, l), std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//  Threads that share out ranges of indices, with work stealing.
+//
+//  parallelFor() splits [0, count) evenly over the threads (the calling
+//  thread is one of them).  Each thread takes "chunk" indices at a time
+//  off the front of its own range; a thread whose range is empty steals
+//  the back half of another's, so threads that get the slow queries
+//  don't hold up the rest.  A range is one 64 bit atomic (first, last)
+//  changed by compare and swap, so taking and stealing need no lock.
+//  The threads are started once and sleep between calls.
+//
+class WorkPool {
+public:
+	WorkPool(int threads = 0);      // 0 = one per core
+	~WorkPool();
+	int size() const { return workers.size() + 1; }
+
+	// f(first, last, thread) over all of [0, count), in pieces of at most
+	// "chunk"; returns when every piece is done.  "thread" is 0 for the
+	// caller, 1 .. size() - 1 for the pool's threads.  One call at a time
+	//
+	template <class F> void parallelFor(int count, int chunk, F f) {
+		std::function<void(int, int, int)> fn(f);
+		run(count, chunk, fn);
+	}
+	void run(int count, int chunk, const std::function<void(int, int, int)> &f);
+
+	std::atomic<long> steals;       // ranges taken from another thread, since construction
+
+private:
+	class alignas(64) Range {
+	public:
+		std::atomic<uint64_t> span;     // first << 32 | last
+	};
+
+	void loop(int thread);
+	void work(int thread);
+	bool take(int thread, int &first, int &last);
+	bool steal(int thread, int &first, int &last);
+
+	vector<std::thread> workers;
+	std::unique_ptr<Range[]> ranges;
+	const std::function<void(int, int, int)> *job;
+	int chunk;
+	std::mutex lock;
+	std::condition_variable started, finished;
+	uint64_t generation;
+	int running;
+	bool bQuit;
+};
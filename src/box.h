@@ -4,6 +4,7 @@
 #include <assert.h>
 #include "vector3.h"
 #include "ray.h"
+#include "Vec4.h"
 
 /*
  * Axis-aligned bounding box class, for use with the optimized ray-box
@@ -29,14 +30,16 @@ class Box {
     // corners
     Vector3 parameters[2];
 
-	Vector3 min() { return parameters[0]; }
-	Vector3 max() { return parameters[1]; }
-	const bool inside(const Vector3 &p) {
-		return ((p.x() >= parameters[0].x() && p.x() <= parameters[1].x()) &&
-		     	(p.y() >= parameters[0].y() && p.y() <= parameters[1].y()) &&
-			    (p.z() >= parameters[0].z() && p.z() <= parameters[1].z()));
+	Vector3 min() const { return parameters[0]; }
+	Vector3 max() const { return parameters[1]; }
+	bool inside(const Vector3 &p) const {
+		return inside(Vec4::load3(p));
 	}
-	const bool inside(Vector3 *points, int size) {
+	bool inside(const Vec4 &p) const {
+		return Vec4::allLessEqual3(Vec4::load3(parameters[0]), p) &&
+			Vec4::allLessEqual3(p, Vec4::load3(parameters[1]));
+	}
+	bool inside(const Vector3 *points, int size) const {
 		bool allInside = true;
 		for (int i = 0; i < size; i++) {
 			if (!inside(points[i])) allInside = false;
@@ -47,23 +50,20 @@ class Box {
 
 	// implement for Homework Project
 	//
-	 bool overlap(const Box &box) {
+	 bool overlap(const Box &box) const {
 		 //if the argument box overlaps with this box, we return true
 		 //note: parameter[0] is min and parameter[1] is max
 		 //Want to work with axis aligned bounding boxes (AABB)
 
 
-		 return((box.parameters[0].x() <= parameters[1].x() &&
-			 box.parameters[1].x() >= parameters[0].x()) &&
-			 (box.parameters[0].y() <= parameters[1].y() &&
-				 box.parameters[1].y() >= parameters[0].y()) &&
-			 (box.parameters[0].z() <= parameters[1].z() &&
-				 box.parameters[1].z() >= parameters[0].z()));
+		 //all three axes at once: box.min <= max and min <= box.max
+		 return Vec4::allLessEqual3(Vec4::load3(box.parameters[0]), Vec4::load3(parameters[1])) &&
+			 Vec4::allLessEqual3(Vec4::load3(parameters[0]), Vec4::load3(box.parameters[1]));
 
 		 //return false;
 	}
 
-	Vector3 center() {
+	Vector3 center() const {
 		return ((max() - min()) / 2 + min());
 	}
 };
@@ -62,9 +62,12 @@ void ofApp::setup(){
 	gui.add(numLevels.setup("Number of Octree Levels", 1, 1, 10));
 	bHide = true;
 
-	//  Create Octree
+	//  Create Octree, only its top levels now, the rest as the lander
+	//  and the mouse queries reach it
+	octree.bLazy = true;
 	octree.create(mars.getMesh(0), 20);
-	
+	voxels.build(mars.getMesh(0));
+
 	testBox = Box(Vector3(3, 3, 0), Vector3(5, 5, 2));
 
 
@@ -78,51 +81,23 @@ void ofApp::setup(){
 	bFollow = true;
 
 
-	//Forces, thrusts have no initial force
-	gravityForce = new GravityForce(ofVec3f(0, -gravity, 0)); //moon's gravity
-	thrustForceX = new ThrustForce(ofVec3f(0, 0, 0));
-	thrustForceY = new ThrustForce(ofVec3f(0, 0, 0));
-	thrustForceZ = new ThrustForce(ofVec3f(0, 0, 0));
-
-	//forces for emitters
-	radialForce = new ImpulseRadialForce(1000.0);
-	turbForce = new TurbulenceForce(glm::vec3(-90, -90, -90),
-		glm::vec3(90, 90, 90));
-
-	player.mass = 50;
-	fuel = 2500;
-
-	targetArea = Box(Vector3(-24.6, -1, 5. - 24.6), Vector3(24.6, 1.5, 24.6));
+	//game simulation: forces, emitters, fuel and landing rules
+	sim.setup(&octree);
+	sim.narrowPhase.voxels = &voxels;
+	sim.clock.setStep(1.0 / timestep.rate);
 
 	//spawn lander here
 	spawnLander(glm::vec3(0, 50, 0));
-	sys.add(player);
-	sys.addForce(gravityForce);
-	sys.addForce(thrustForceX);
-	sys.addForce(thrustForceY);
-	sys.addForce(thrustForceZ);
-
-	explodeEmitter.sys->addForce(radialForce);
-	explodeEmitter.setVelocity(ofVec3f(0, 0, 0));
-	explodeEmitter.setOneShot(true);
-	explodeEmitter.setEmitterType(RadialEmitter);
-	explodeEmitter.setGroupSize(500);
-
-	thrustEmitter.velocity = glm::vec3(0, -15, 0);
-	thrustEmitter.rate = 70;
-	thrustEmitter.setEmitterType(DirectionalEmitter);
-	thrustEmitter.setGroupSize(70);
-	thrustEmitter.lifespan = 0.15;
-	thrustEmitter.setParticleRadius(0.05);
-	thrustEmitter.sys->addForce(turbForce);
+
+	staging.setBackend(&particleVbo);
+
+	particleRenderer.setup();
+	sim.explodeEmitter.renderer = &particleRenderer;
+	sim.thrustEmitter.renderer = &particleRenderer;
 
 
 	//setupLights(); /set up landing position lights and spacecraft lights
-	bStarted = false;
-	//bInside = true;
 	bAltitude = true;
-	bGame = false;
-	bLife = true;
 
 }
  
@@ -130,59 +105,57 @@ void ofApp::setup(){
 // incrementally update scene (animation)
 //
 void ofApp::update() {
+	PROFILE_ZONE("update");
 
+	// allocations from the start of the last update to now, a whole frame
+	//
+	AllocCounter::Snapshot now = AllocCounter::snapshot();
+	frameAllocs = (now - frameStart).allocations;
+	frameStart = now;
 
-	//Only move the craft when game is running and set positions
-	// If game is not running, we can drag the lander around
+	// run physics in fixed size steps, however long the last frame took
 	//
-	if (bGame == true) {
-		sys.update();
+	int steps = timestep.advance(ofGetLastFrameTime());
+	for (int i = 0; i < steps; i++) {
+		sim.step();
+	}
 
-		if (sys.particles.size() > 0) {
-			player.position = sys.particles[0].position;
-		}
-		
+	// draw everything part way between the last two physics states
+	//
+	float alpha = timestep.alpha();
+	sim.explodeEmitter.sys->renderAlpha = alpha;
+	sim.thrustEmitter.sys->renderAlpha = alpha;
 
-		lander.setPosition(player.position.x, player.position.y, player.position.z);
-		thrustEmitter.setPosition(lander.getPosition());
-		shipLight.setPosition(player.position);
+	if (sim.bGame == true && sim.sys.particles.size() > 0) {
+		ofVec3f p = sim.sys.particles[0].renderPosition(alpha);
+		lander.setPosition(p.x, p.y, p.z);
+		landerProxy.setTransform(p);
+		shipLight.setPosition(p);
 	}
 
-	
-	for (auto& p : explodeEmitter.sys->particles) {
-		p.position.set(ofVec3f(player.position));
+	// game over, save its inputs (replay with tools/replay)
+	if (inputLog.bRecording && !sim.bGame) {
+		inputLog.end(sim);
+		if (inputLog.save(ofToDataPath("last-run.inputs"))) cout << "inputs saved to last-run.inputs" << endl;
 	}
 
-
-	
-	//if (explodeEmitter.started) {
-		explodeEmitter.update();
-	//}
-	//if (thrustEmitter.started) {
-		thrustEmitter.update();
-	//}
-	
-	//explodeEmitter.update();
-	//thrustEmitter.update();
-
 	updateCamera();
-	checkCollision();
-	calculateAltitude();
-
-	// consume fuel
-	if (bThruster == true && fuel >= 0 && bGame == true) {
-		fuel--;
-		thrustEmitter.start();
+	sim.calculateAltitude();
 
+	// crashed: play the explosion sound only once and flip the lander over
+	if (sim.bLife == false && !bExplSound) {
+		explSound.play();
+		bExplSound = true;
+		lander.setRotation(1, 180, 1, 0, 0);
+	}
 
-		//also play thruster sound here
+	// thruster sound
+	if (sim.thrustEmitter.started) {
 		if (!thrustSound.getIsPlaying()) {
 			thrustSound.play();
 		}
-		
 	}
 	else {
-		thrustEmitter.stop();
 		thrustSound.stop();
 	}
 	
@@ -191,6 +164,7 @@ void ofApp::update() {
 }
 //--------------------------------------------------------------
 void ofApp::draw() {
+	PROFILE_ZONE("draw");
 
 	ofBackground(ofColor::black);
 	
@@ -244,12 +218,8 @@ void ofApp::draw() {
 
 			if (bLanderSelected) {
 
-				ofVec3f min = lander.getSceneMin() + lander.getPosition();
-				ofVec3f max = lander.getSceneMax() + lander.getPosition();
-
-				Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
 				ofSetColor(ofColor::white);
-				Octree::drawBox(bounds);
+				Octree::drawBox(landerProxy.worldBounds());
 
 				// draw colliding boxes
 				//
@@ -284,7 +254,7 @@ void ofApp::draw() {
 	ofEnablePointSprites();
 	shader.begin();
 	particleTex.bind();
-	vbo.draw(GL_POINTS, 0, (int)thrustEmitter.sys->particles.size());
+	particleVbo.vbo.draw(GL_POINTS, 0, staging.count());
 	particleTex.unbind();
 	shader.end();
 	ofDisablePointSprites();
@@ -334,17 +304,17 @@ void ofApp::draw() {
 	ofSetColor(ofColor::red);
 
 	//if(explodeEmitter.started)
-	explodeEmitter.draw();
+	sim.explodeEmitter.draw();
 
 	//if (thrustEmitter.started)
-	thrustEmitter.draw();
+	sim.thrustEmitter.draw();
 
 	//easyCam.end();				//easyCam?
 	theCam->end();
 	ofDisableDepthTest();
-	ofDrawBitmapString("FUEL: " + ofToString(fuel), 0, 125, 0);
+	ofDrawBitmapString("FUEL: " + ofToString(sim.fuel), 0, 125, 0);
 	if(bAltitude)
-		ofDrawBitmapString("AGL: " + ofToString(altitude), 0, 150, 0);
+		ofDrawBitmapString("AGL: " + ofToString(sim.altitude), 0, 150, 0);
 
 	if (currentCam == 0) {
 		ofDrawBitmapString("CAMERA: EASY CAM", 0, 100, 0);
@@ -356,7 +326,20 @@ void ofApp::draw() {
 		ofDrawBitmapString("CAMERA: TRACK CAM", 0, 100, 0);
 	}
 
-	if (bLife == false) {
+	if (bProfile) {
+		if (AllocCounter::enabled()) {
+			ofDrawBitmapString("allocations/frame: " + ofToString(frameAllocs), ofGetWindowWidth() - 520, 20);
+		}
+		auto cache = [&](const string &name, const CoherentStats &s, float y) {
+			ofDrawBitmapString(name + ": " + ofToString(s.hitRate() * 100, 1) + "% cached, " +
+				ofToString(s.nodesPerQuery(), 1) + " nodes/query", ofGetWindowWidth() - 520, y);
+		};
+		cache("collision", sim.narrowPhase.query.stats, 34);
+		cache("altitude", sim.altitudeQuery.stats, 48);
+		Profiler::draw(ofGetWindowWidth() - 520, 68);
+	}
+
+	if (sim.bLife == false) {
 		ofDrawBitmapString("STATUS: --CRASHED--", 0, 75, 0);
 		ofDrawBitmapString("CRASHED - MISSION FAILED",
 			ofGetWindowWidth() / 2 - 100, ofGetWindowHeight() / 2, 0);
@@ -365,17 +348,17 @@ void ofApp::draw() {
 		ofDrawBitmapString("STATUS: --OPERATIONAL--", 0, 75, 0);
 	}
 
-	if (bStarted == false) {
+	if (sim.bStarted == false) {
 		ofDrawBitmapString("STANDBY - PRESS [SPACE BAR] TO START",
 			ofGetWindowWidth() / 2 - 100, ofGetWindowHeight() / 2, 0);
 	}
 
-	if (bInside == true && bGame == false && bStarted == true && bLife == true) {
+	if (sim.bInside == true && sim.bGame == false && sim.bStarted == true && sim.bLife == true) {
 		ofDrawBitmapString("LANDED INSIDE - MISSON ACCOMPLISHED",
 			ofGetWindowWidth()/2 - 100, ofGetWindowHeight()/2, 0);
 			//0, 0, 0);
 	}
-	else if ( bInside == false && bGame == false && bStarted == true && bLife == true) {
+	else if ( sim.bInside == false && sim.bGame == false && sim.bStarted == true && sim.bLife == true) {
 		ofDrawBitmapString("LANDED OUTSIDE - MISSION FAILED",
 			ofGetWindowWidth()/2 - 100, ofGetWindowHeight()/2 , 0);
 			//0, 0, 0);
@@ -414,12 +397,15 @@ void ofApp::drawAxis(ofVec3f location) {
 
 void ofApp::keyPressed(int key) {
 
+	// lander controls go to the simulation and are recorded;
+	// the space bar that starts a game starts a new recording
+	if (key == ' ' && !sim.bGame && !inputLog.bRecording) inputLog.begin(sim);
+	if (sim.keyPressed(key)) {
+		inputLog.record(sim.clock.ticks, key, true);
+		return;
+	}
+
 	switch (key) {
-	case 'A':
-	case 'a':
-		bThruster = true;
-		player.angularVel = -30;
-		break;
 	case 'B':
 	case 'b':
 		bDisplayBBoxes = !bDisplayBBoxes;
@@ -429,11 +415,6 @@ void ofApp::keyPressed(int key) {
 		if (cam.getMouseInputEnabled()) cam.disableMouseInput();
 		else cam.enableMouseInput();
 		break;
-	case 'D':
-	case 'd':
-		bThruster = true;
-		player.angularVel = 30;
-		break;
 	case 'F':
 	case 'f':
 		ofToggleFullscreen();
@@ -450,6 +431,15 @@ void ofApp::keyPressed(int key) {
 	case 'o':
 		bDisplayOctree = !bDisplayOctree;
 		break;
+	case 'P':
+	case 'p':
+		bProfile = !bProfile; //timing overlay
+		Profiler::enable(bProfile);
+		break;
+	case 'M':
+	case 'm':
+		sim.printMemory(cout);
+		break;
 	case 'r':
 		cam.reset();
 		break;
@@ -471,40 +461,10 @@ void ofApp::keyPressed(int key) {
 	case 'w':
 		toggleWireframeMode();
 		break;
-	case 'X':
-	case 'x':
-		thrustForceY->setForce(ofVec3f(0, -100, 0));
-		bThruster = true;
-		break;
 	case 'Y':
 	case 'y':
 		bFollow = !bFollow; //toggle easyCam follow
 		break;
-	case 'Z':
-	case 'z':
-		thrustForceY->setForce(ofVec3f(0, 100, 0));
-		bThruster = true;
-		break;
-	case OF_KEY_UP:
-		//code
-		thrustForceZ->setForce(ofVec3f(0, 0, 100));
-		bThruster = true;
-		break;
-	case OF_KEY_DOWN:
-		//code
-		thrustForceZ->setForce(ofVec3f(0, 0, -100));
-		bThruster = true;
-		break;
-	case OF_KEY_LEFT:
-		//code
-		thrustForceX->setForce(ofVec3f(-100, 0, 0));
-		bThruster = true;
-		break;
-	case OF_KEY_RIGHT:
-		//code
-		thrustForceX->setForce(ofVec3f(100, 0, 0));
-		bThruster = true;
-		break;
 	case OF_KEY_ALT:
 		cam.enableMouseInput();
 		bAltKeyDown = true;
@@ -516,10 +476,6 @@ void ofApp::keyPressed(int key) {
 		break;
 	case OF_KEY_DEL:
 		break;
-	case ' ':
-		bStarted = true;
-		bGame = true;
-		break;
 	case '1':
 		theCam = &cam;
 		currentCam = 0;
@@ -552,47 +508,12 @@ void ofApp::togglePointsDisplay() {
 
 void ofApp::keyReleased(int key) {
 
+	if (sim.keyReleased(key)) {
+		inputLog.record(sim.clock.ticks, key, false);
+		return;
+	}
+
 	switch (key) {
-	case 'A':
-	case 'a':
-		bThruster = false;
-		player.angularVel = 0;
-		break;
-	case 'D':
-	case 'd':
-		bThruster = false;
-		player.angularVel = 0;
-		break;
-	case 'X':
-	case 'x':
-		thrustForceY->setForce(ofVec3f(0, 0, 0));
-		bThruster = false;
-		break;
-	case 'Z':
-	case 'z':
-		thrustForceY->setForce(ofVec3f(0, 0, 0));
-		bThruster = false;
-		break;
-	case OF_KEY_UP:
-		//code
-		thrustForceZ->setForce(ofVec3f(0,0,0));
-		bThruster = false;
-		break;
-	case OF_KEY_DOWN:
-		//code
-		thrustForceZ->setForce(ofVec3f(0, 0, 0));
-		bThruster = false;
-		break;
-	case OF_KEY_LEFT:
-		//code
-		thrustForceX->setForce(ofVec3f(0, 0, 0));
-		bThruster = false;
-		break;
-	case OF_KEY_RIGHT:
-		//code
-		thrustForceX->setForce(ofVec3f(0, 0, 0));
-		bThruster = false;
-		break;
 	case OF_KEY_ALT:
 		cam.disableMouseInput();
 		bAltKeyDown = false;
@@ -635,16 +556,12 @@ void ofApp::mousePressed(int x, int y, int button) {
 		glm::vec3 mouseWorld = cam.screenToWorld(glm::vec3(mouseX, mouseY, 0));
 		glm::vec3 mouseDir = glm::normalize(mouseWorld - origin);
 
-		ofVec3f min = lander.getSceneMin() + lander.getPosition();
-		ofVec3f max = lander.getSceneMax() + lander.getPosition();
-
-		Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
-		bool hit = bounds.intersect(Ray(Vector3(origin.x, origin.y, origin.z), Vector3(mouseDir.x, mouseDir.y, mouseDir.z)), 0, 10000);
+		bool hit = landerProxy.worldBounds().intersect(Ray(toVector3(origin), toVector3(mouseDir)), 0, 10000);
 		if (hit) {
 			bLanderSelected = true;
 			mouseDownPos = getMousePointOnPlane(lander.getPosition(), cam.getZAxis());
 			mouseLastPos = mouseDownPos;
-			if (bGame == false) {
+			if (sim.bGame == false) {
 				bInDrag = true; //only enable dragging when game is not running
 			}
 				
@@ -654,13 +571,9 @@ void ofApp::mousePressed(int x, int y, int button) {
 		}
 	}
 	else {
-		//start timer here
-		startTime = ofGetElapsedTimeMicros();
+		PROFILE_ZONE("raySelectWithOctree");
 		ofVec3f p;
 		raySelectWithOctree(p);
-		endTime = ofGetElapsedTimeMicros();
-		totalTime = endTime - startTime;
-		//cout << "Time:" << totalTime << " microseconds" << endl;
 	}
 }
 
@@ -669,8 +582,7 @@ bool ofApp::raySelectWithOctree(ofVec3f &pointRet) {
 	ofVec3f rayPoint = cam.screenToWorld(mouse);
 	ofVec3f rayDir = rayPoint - cam.getPosition();
 	rayDir.normalize();
-	Ray ray = Ray(Vector3(rayPoint.x, rayPoint.y, rayPoint.z),
-		Vector3(rayDir.x, rayDir.y, rayDir.z));
+	Ray ray = Ray(toVector3(rayPoint), toVector3(rayDir));
 
 	pointSelected = octree.intersect(ray, octree.root, selectedNode);
 
@@ -701,16 +613,12 @@ void ofApp::mouseDragged(int x, int y, int button) {
 
 			landerPos += delta;
 			lander.setPosition(landerPos.x, landerPos.y, landerPos.z);
-			player.position = lander.getPosition();
+			sim.player.position = lander.getPosition();
+			landerProxy.setTransform(landerPos);
 			mouseLastPos = mousePos;
 
-			ofVec3f min = lander.getSceneMin() + lander.getPosition();
-			ofVec3f max = lander.getSceneMax() + lander.getPosition();
-
-			Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
-
 			colBoxList.clear();
-			octree.intersect(bounds, octree.root, colBoxList);
+			octree.intersect(landerProxy.worldBounds(), octree.root, colBoxList);
 		}
 
 
@@ -730,27 +638,35 @@ void ofApp::mouseReleased(int x, int y, int button) {
 
 void ofApp::spawnLander(glm::vec3 spawnPos) {
 
-	//if(lander.loadModel("geo/lander.obj")){ //tells to load the model
+	// only load the model (and read its bounds) the first time
+	if (!bLanderLoaded) {
 		lander.loadModel("geo/lander.obj");
 		lander.setScaleNormalization(false); //do not normalize
-
-		player.position = ofVec3f(spawnPos.x, spawnPos.y, spawnPos.z); //sets position
-		lander.setPosition(player.position.x, player.position.y, player.position.z);
 		bLanderLoaded = true;
+		loadLanderBounds();
+	}
 
-		for (int i = 0; i < lander.getMeshCount(); i++) {
-			bboxList.push_back(Octree::meshBounds(lander.getMesh(i)));
-		}
+	lander.setPosition(spawnPos.x, spawnPos.y, spawnPos.z); //sets position
+	landerProxy.setTransform(ofVec3f(spawnPos.x, spawnPos.y, spawnPos.z));
+	sim.spawn(ofVec3f(spawnPos.x, spawnPos.y, spawnPos.z));
+		
+}
 
-		// Now position the lander's origin at that intersection point
-			//
-		glm::vec3 min = lander.getSceneMin();
-		glm::vec3 max = lander.getSceneMax();
+// Read the bounds of a newly loaded lander model, once per load
+//
+void ofApp::loadLanderBounds() {
+	bboxList.clear();
+	for (int i = 0; i < lander.getMeshCount(); i++) {
+		bboxList.push_back(Octree::meshBounds(lander.getMesh(i)));
+	}
 
-		// set up bounding box for lander while we are at it
-		//
-		landerBounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
-		
+	// set up bounding box for lander while we are at it
+	//
+	glm::vec3 min = lander.getSceneMin();
+	glm::vec3 max = lander.getSceneMax();
+	landerBounds = Box(toVector3(min), toVector3(max));
+	landerProxy.setLocalBounds(landerBounds);
+	sim.setLanderBounds(landerBounds);
 }
 
 
@@ -849,9 +765,8 @@ void ofApp::dragEvent2(ofDragInfo dragInfo) {
 		lander.setPosition(1, 1, 0);
 
 		bLanderLoaded = true;
-		for (int i = 0; i < lander.getMeshCount(); i++) {
-			bboxList.push_back(Octree::meshBounds(lander.getMesh(i)));
-		}
+		loadLanderBounds();
+		landerProxy.setTransform(lander.getPosition());
 
 		cout << "Mesh Count: " << lander.getMeshCount() << endl;
 	}
@@ -877,10 +792,7 @@ void ofApp::dragEvent(ofDragInfo dragInfo) {
 		lander.setScaleNormalization(false);
 		lander.setPosition(0, 0, 0);
 		//cout << "number of meshes: " << lander.getNumMeshes() << endl;
-		bboxList.clear();
-		for (int i = 0; i < lander.getMeshCount(); i++) {
-			bboxList.push_back(Octree::meshBounds(lander.getMesh(i)));
-		}
+		loadLanderBounds();
 
 		//		lander.setRotation(1, 180, 1, 0, 0);
 
@@ -915,11 +827,8 @@ void ofApp::dragEvent(ofDragInfo dragInfo) {
 			glm::vec3 max = lander.getSceneMax();
 			float offset = (max.y - min.y) / 2.0;
 			lander.setPosition(intersectPoint.x, intersectPoint.y - offset, intersectPoint.z);
-
-			// set up bounding box for lander while we are at it
-			//
-			landerBounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
 		}
+		landerProxy.setTransform(lander.getPosition());
 	}
 
 
@@ -952,125 +861,10 @@ glm::vec3 ofApp::getMousePointOnPlane(glm::vec3 planePt, glm::vec3 planeNorm) {
 	else return glm::vec3(0, 0, 0);
 }
 
-// Author: Jonathan Nguyen
-// Check if a collision is occuring
-void ofApp::checkCollision() {
-	
-	//need to check this again for the smallest octrees
-	
-
-	ofVec3f min = lander.getSceneMin() + lander.getPosition();
-	ofVec3f max = lander.getSceneMax() + lander.getPosition();
-	Box bounds = Box(Vector3(min.x, min.y, min.z), Vector3(max.x, max.y, max.z));
-
-	nodeList.clear();
-
-	if (octree.intersect(bounds, octree.root, nodeList)) {
-
-		//get the point closest to the lander
-
-		if (nodeList.size() > 0) {
-			TreeNode closestNode = nodeList[0];
-			glm::vec3 closest = octree.mesh.getVertex(nodeList[0].points[0]); //closest point from the closest node
-			glm::vec3 ship = player.position; //position of the ship
-
-			closestDistance = glm::distance(closest, ship);
-			for (int i = 1; i < nodeList.size(); i++) { //check all the other 
-				glm::vec3 vert = octree.mesh.getVertex(nodeList[i].points[0]);
-				float nodeDist = glm::distance(vert, ship);
-
-				if (nodeDist < closestDistance) { //if we find a closer point, set that one as cloest
-					closestNode = nodeList[i];
-					closestDistance = nodeDist;
-				}
-
-			}//end of the for loop
-
-
-			//is the closest node to the terrain close enough to be a collision?
-			if (closestDistance < epsilon) { // look up slides for formula
-				norm = octree.mesh.getNormal(closestNode.points[0]);
-				vel; //collision velocity
-
-				if (sys.particles.size() > 0) {
-					vel = sys.particles[0].velocity;
-				}
-
-				speed = glm::length(vel);
-				collisionVel = fmaxf(collisionVel, speed);
-				//cout << "Contact!" << endl;
-				resolveCollision();
-
-			}
-
-
-		}
-
-	}//end intersect
-	
-}
-
-// Author: Jonathan Nguyen
-// Resolve collision based on speed and area landed
-void ofApp::resolveCollision() {
-
-	if (bGame == true) {
-
-		if (speed >= 5) {
-			//too fast, crashed
-			explodeEmitter.start();
-
-			if (!bExplSound) {
-				explSound.play(); //play the explosion sound only once
-				bExplSound = true;
-
-			}
-
-			//move spacecraft somewhere, launch it I guess
-			lander.setRotation(1, 180, 1, 0, 0);
-			bLife = false; //Very much dead
-			bGame = false;
-		}
-
-		if (speed > 0.5 && speed < 5 && bGame == true) {
-			//not a smooth landing, bounce
-
-			glm::vec3 impulseForce = 100 * (-glm::dot(vel, norm) * norm);
-			//from the lecture slides
-
-			if (sys.particles.size() > 0) {
-				sys.particles[0].forces += impulseForce * ofGetFrameRate();
-			}
-
-		}
-		else { //lander safely landed
-			bGame = false; //stop the game... integrate should stop too
-			
-			//if we land inside the area
-			if (targetArea.inside(Vector3(lander.getPosition().x, lander.getPosition().y,
-				lander.getPosition().z))) {
-
-				bInside = true;
-				//cout << "Good landing" << endl;
-			}
-			else { //outside the target area
-				bInside = false;
-				//cout << "Bad landing" << endl;
-
-			}
-
-		}
-	}
-}
-
 // Author: Jonathan Nguyen
 // Setup cameras
 void ofApp::setupCamera(){
 
-	if (sys.particles.size() > 0) {
-		player.position = sys.particles[0].position;
-	}
-
 	//Easy Cam setup
 	cam.setPosition(150, 110, 200);
 	cam.setTarget(lander.getPosition());
@@ -1078,12 +872,12 @@ void ofApp::setupCamera(){
 
 	//stationary tracking camera
 	trackCam.setPosition(glm::vec3(0, 5, 0)); //stay fixed
-	trackCam.lookAt(player.position);
+	trackCam.lookAt(sim.player.position);
 	trackCam.setNearClip(0.1);
 
-	float landX = player.position.x;
-	float landY = player.position.y;
-	float landZ = player.position.z;
+	float landX = sim.player.position.x;
+	float landY = sim.player.position.y;
+	float landZ = sim.player.position.z;
 
 	shipCam.setPosition(landX+1, landY+0.5, landZ+1);
 	shipCam.lookAt(ofVec3f(), ofVec3f(-0.5, 0, -0.5));
@@ -1094,22 +888,18 @@ void ofApp::setupCamera(){
 // Update cameras to point target
 void ofApp::updateCamera(){
 
-	if (sys.particles.size() > 0) {
-		player.position = sys.particles[0].position;
-	}
-
 	if(bFollow) {
 		cam.setTarget(lander.getPosition());
 		cam.setDistance(30);
 	}
 
 	//stationary, does not move
-	trackCam.lookAt(player.position);
+	trackCam.lookAt(sim.player.position);
 
 	//moves with lander
-	float landX = player.position.x;
-	float landY = player.position.y;
-	float landZ = player.position.z;
+	float landX = sim.player.position.x;
+	float landY = sim.player.position.y;
+	float landZ = sim.player.position.z;
 	shipCam.setPosition(landX - 1, landY + 0.5, landZ - 1);
 	shipCam.lookAt(ofVec3f(), ofVec3f(-0.5, 0, -0.5));
 }
@@ -1117,21 +907,12 @@ void ofApp::updateCamera(){
 // Author: Jonathan Nguyen
 //    For shader
 void ofApp::loadVbo() {
-	if (thrustEmitter.sys->particles.size() < 1) return;
+	PROFILE_ZONE("loadVbo");
 
-	vector<ofVec3f> sizes;
-	vector<ofVec3f> points;
-	for (int i = 0; i < thrustEmitter.sys->particles.size(); i++) {
-		points.push_back(thrustEmitter.sys->particles[i].position);
-		sizes.push_back(ofVec3f(50));
-	}
-	// upload the data to the vbo
+	// stream the live particles at their interpolated render positions
 	//
-	int total = (int)points.size();
-	vbo.clear();
-	vbo.setVertexData(&points[0], total, GL_STATIC_DRAW);
-	vbo.setNormalData(&sizes[0], total, GL_STATIC_DRAW);
-
+	ParticleSystem *sys = sim.thrustEmitter.sys;
+	staging.update(sys->particles, sys->renderAlpha);
 }
 
 // Author: Jonathan Nguyen
@@ -1151,24 +932,6 @@ void ofApp::rotateCamera()
 	*/
 }
 
-// Author: Jonathan Nguyen
-//Get the current altitude using ray-intersect
-void ofApp::calculateAltitude(){
-	Vector3 landerPosition = Vector3(lander.getPosition().x,
-		lander.getPosition().y, lander.getPosition().z);
-
-	altitudeRadar = Ray(landerPosition, Vector3(0, -1, 0)); //straight down
-	if (octree.intersect(altitudeRadar, octree.root, ground)) {
-
-		//if intersected, get the altitude
-		altitude = glm::distance(glm::vec3(lander.getPosition()),
-			glm::vec3(octree.mesh.getVertex(ground.points[0])));
-
-
-	}
-
-}
-
 // Author: Jonathan Nguyen
 // Setup Lights (unused)
 void ofApp::setupLights() {
@@ -1204,6 +967,6 @@ void ofApp::setupLights() {
 	shipLight.setup();
 	shipLight.enable();
 	shipLight.setPointLight();
-	shipLight.setPosition(player.position);
+	shipLight.setPosition(sim.player.position);
 	
 }
\ No newline at end of file
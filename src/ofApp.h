@@ -13,9 +13,15 @@
 #include "ofxGui.h"
 #include  "ofxAssimpModelLoader.h"
 #include "Octree.h"
+#include "VoxelOctree.h"
 #include "Particle.h"
-#include "ParticleSystem.h"
-#include "ParticleEmitter.h"
+#include "LanderSim.h"
+#include "InputLog.h"
+#include "Profiler.h"
+#include "AllocCounter.h"
+#include "FixedTimestep.h"
+#include "ParticleStaging.h"
+#include "ParticleRenderer.h"
 
 
 
@@ -63,6 +69,7 @@ class ofApp : public ofBaseApp{
 		vector<TreeNode> nodeList;
 		bool bLanderSelected = false;
 		Octree octree;
+		VoxelOctree voxels;     // broad phase in front of the octree for lander collisions
 		TreeNode selectedNode;
 		glm::vec3 mouseDownPos, mouseLastPos;
 		bool bInDrag = false;
@@ -92,46 +99,15 @@ class ofApp : public ofBaseApp{
 
 		const float selectionRange = 4.0;
 
-		//for running time tests
-		int startTime;
-		int endTime;
-		int totalTime;
-
-		Particle player;
-		ParticleSystem sys;
-		ThrustForce* thrustForceX; //left and right
-		ThrustForce* thrustForceY; //up and down
-		ThrustForce* thrustForceZ; //fwd and back
-		GravityForce* gravityForce; //down only
-		TurbulenceForce* turbForce; //for thruster emitter
-
-		ImpulseRadialForce* radialForce;
-		ParticleEmitter thrustEmitter; //movement
-		ParticleEmitter explodeEmitter; //for crashing
-
-		float fuel;
-		float altitude;
-		Ray altitudeRadar;
-		TreeNode ground;
-		float gravity = 1.62; //moon's gravity is 1.62 m/s^2
-		float epsilon = 1;
-	
+		bool bProfile = false; //zone timings drawn on screen
+		AllocCounter::Snapshot frameStart = { 0, 0, 0 }; //heap allocations at the start of the frame
+		uint64_t frameAllocs = 0; //during the last frame (LANDER_COUNT_ALLOCS builds)
+
+		LanderSim sim; //lander physics, fuel, collision and game state
+		InputLog inputLog; //lander controls of the current game, for replay
 
-		bool bThruster; //used to check if thrusters are on or not
 		bool bAltitude;
-		bool bGame; //check if game is running or not
 		bool bFollow; //is camera following spacecraft?
-		bool bLife = true; //intact or combusted?
-		bool bInside; //landed inside or not
-		bool bStarted; //standby at the beginning
-
-
-		float closestDistance;
-		float collisionVel;
-		float speed;
-		glm::vec3 vel;
-		glm::vec3 norm;
-		Box targetArea; //place to land, should be the higher res area on terrain
 
 		ofLight keyLight, fillLight, rimLight; //for landing spot
 		ofLight shipLight; //for the ship
@@ -146,12 +122,15 @@ class ofApp : public ofBaseApp{
 		bool bExplSound = false;
 		ofImage background;
 		void spawnLander(glm::vec3 spawnPos);
-		void checkCollision();
-		void resolveCollision();
-		void calculateAltitude();
+		void loadLanderBounds();
+		LanderProxy landerProxy; //cached lander bounds, updated when it moves
+
+		FixedTimestep timestep; //physics runs at a fixed rate (120 Hz)
 
 		ofShader shader;
-		ofVbo vbo;
+		VboStagingBackend particleVbo;
+		ParticleStaging staging; //streams thrust particles to particleVbo
+		ParticleRenderer particleRenderer; //one instanced draw per particle system
 		ofTexture particleTex;
 		void loadVbo();
 
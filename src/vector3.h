@@ -15,6 +15,7 @@ class Vector3 {
     float z() const { return d[2]; }
 
     float operator[](int i) const { return d[i]; }
+    const float *data() const { return d; }   // x, y, z packed
     
     float length() const
       { return sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]); }
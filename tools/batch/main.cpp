@@ -0,0 +1,72 @@
+//--------------------------------------------------------------
+//
+//  Lunar Lander - batch landing simulator
+//
+//  Monte-Carlo runs of LanderSim on all cores for tuning the gameplay
+//  parameters.  Built by tools/CMakeLists.txt against the simulation
+//  sources in src/ and openFrameworks core.
+//
+//  usage: batch [-n trials] [-threads n] [-seed n] [-control scripted|random]
+//               [-gravity g] [-crash speed] [-bounce speed] [-thrust f]
+//               [-fuel f] [-terrain file.obj] [-levels n] [-hz rate]
+//               [-maxtime sec] [-effects]
+//
+
+#include "ofMain.h"
+#include "LanderBatch.h"
+#include "Terrain.h"
+
+int main(int argc, char *argv[]) {
+	long trials = 10000;
+	int threads = 0;
+	int levels = 20;
+	string terrainFile;
+	LanderParams params;
+	params.bEffects = false;    // particles don't change the outcome
+	LanderBatch batch;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool more = i + 1 < argc;
+		if (arg == "-n" && more) trials = atol(argv[++i]);
+		else if (arg == "-threads" && more) threads = atoi(argv[++i]);
+		else if (arg == "-seed" && more) batch.seed = strtoull(argv[++i], NULL, 10);
+		else if (arg == "-control" && more) {
+			string c = argv[++i];
+			batch.control = (c == "random") ? RandomControl : ScriptedControl;
+		}
+		else if (arg == "-gravity" && more) params.gravity = atof(argv[++i]);
+		else if (arg == "-crash" && more) params.crashSpeed = atof(argv[++i]);
+		else if (arg == "-bounce" && more) params.bounceSpeed = atof(argv[++i]);
+		else if (arg == "-thrust" && more) params.thrust = atof(argv[++i]);
+		else if (arg == "-fuel" && more) params.fuel = atof(argv[++i]);
+		else if (arg == "-terrain" && more) terrainFile = argv[++i];
+		else if (arg == "-levels" && more) levels = atoi(argv[++i]);
+		else if (arg == "-hz" && more) batch.hz = atof(argv[++i]);
+		else if (arg == "-maxtime" && more) batch.maxTime = atof(argv[++i]);
+		else if (arg == "-effects") params.bEffects = true;
+		else {
+			cout << "unknown option " << arg << endl;
+			return 1;
+		}
+	}
+
+	ofMesh terrain;
+	if (terrainFile.empty()) Terrain::heightfield(terrain);
+	else if (!Terrain::loadObj(terrainFile, terrain)) {
+		cout << "Can't load terrain " << terrainFile << endl;
+		return 1;
+	}
+	Octree octree;
+	octree.create(terrain, levels);
+
+	batch.setup(&octree, Box(Vector3(-1, 0, -1), Vector3(1, 2, 1)), params);
+
+	cout << "gravity " << params.gravity << ", crash speed " << params.crashSpeed
+		<< ", bounce speed " << params.bounceSpeed << ", thrust " << params.thrust
+		<< ", " << (batch.control == RandomControl ? "random" : "scripted") << " control" << endl;
+
+	BatchStats stats = batch.run(trials, threads);
+	stats.print(cout);
+	return 0;
+}
@@ -0,0 +1,1462 @@
+//--------------------------------------------------------------
+//
+//  Lunar Lander - subsystem benchmarks
+//
+//  Console program, no window or GL context.  Built by
+//  tools/CMakeLists.txt against the simulation sources in src/ and
+//  openFrameworks core.
+//
+//  usage: bench [-res n]... [-levels n] [-only group,...] [-json file]
+//               [-tag text]
+//
+//  Terrain benchmarks run once per -res (procedural heightfields of
+//  res x res vertices, 129 and 257 by default).  Groups are spawn,
+//  staging, batch, contacts, octree, compact, order, ropes, coherent,
+//  lazy, threads, parallel, voxels, memory, template, box, vector
+//  and particles.  -json writes every result (ns per item) to a file for
+//  comparing runs across commits; -tag labels the run, e.g. with the
+//  commit hash.
+//  Built with LANDER_COUNT_ALLOCS, heap allocations per item are
+//  reported too (see AllocCounter.h).
+//
+
+#include "ofMain.h"
+#include "ParticleEmitter.h"
+#include "ParticleStaging.h"
+#include "ParticleBatch.h"
+#include "NarrowPhase.h"
+#include "CompactOctree.h"
+#include "CoherentQuery.h"
+#include "OctreeBatch.h"
+#include "VoxelOctree.h"
+#include "Terrain.h"
+#include "AllocCounter.h"
+#include <cfloat>
+#include <fstream>
+#include <thread>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class BenchResult {
+public:
+	string name;
+	double ns;          // per item
+	int reps;
+	int items;
+	double allocs;      // per item, LANDER_COUNT_ALLOCS builds only
+};
+static vector<BenchResult> results;
+
+//  sizes, counts and bytes of data structures, from the memory group
+//
+static vector<pair<string, double>> counters;
+
+//  sink for values computed only to be timed, so they aren't optimized away
+//
+static volatile long benchSink;
+
+//  time "reps" runs of f() and print the cost per item
+//
+template <class F>
+double bench(const string &name, int reps, int items, F f) {
+	AllocCounter::Snapshot a1 = AllocCounter::snapshot();
+	auto t1 = chrono::steady_clock::now();
+	for (int i = 0; i < reps; i++) f();
+	auto t2 = chrono::steady_clock::now();
+	AllocCounter::Snapshot a2 = AllocCounter::snapshot();
+	double ns = chrono::duration<double, nano>(t2 - t1).count() / ((double)reps * items);
+	double allocs = (a2 - a1).allocations / ((double)reps * items);
+	cout << name << ": " << ns << " ns/item";
+	if (AllocCounter::enabled()) cout << ", " << allocs << " allocations/item";
+	cout << endl;
+	results.push_back({ name, ns, reps, items, allocs });
+	return ns;
+}
+
+//  the old spawn path - ofRandom(), one default constructed particle
+//  and one push_back per particle
+//
+static void spawnEach(ParticleEmitter &e, int n, float time) {
+	for (int i = 0; i < n; i++) {
+		Particle particle;
+		ofVec3f dir = ofVec3f(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1));
+		float speed = e.velocity.length();
+		particle.velocity = dir.getNormalized() * speed;
+		particle.position.set(e.position);
+		particle.lifespan = e.lifespan;
+		particle.birthtime = time;
+		particle.radius = e.particleRadius;
+		e.sys->add(particle);
+	}
+}
+
+static void benchSpawn() {
+	const int group = 500;
+	const int reps = 2000;
+
+	ParticleEmitter e;
+	e.setEmitterType(RadialEmitter);
+	e.setVelocity(ofVec3f(0, 10, 0));
+
+	double each = bench("spawn (per particle)", reps, group, [&]() {
+		e.sys->particles.clear();
+		spawnEach(e, group, 0);
+	});
+	double batch = bench("spawnBatch", reps, group, [&]() {
+		e.sys->particles.clear();
+		e.spawnBatch(group, 0);
+	});
+	cout << "spawnBatch speedup: " << each / batch << "x" << endl;
+
+	bench("ParticleEmitter::spawn", reps, group, [&]() {
+		e.sys->particles.clear();
+		for (int i = 0; i < group; i++) e.spawn(0);
+	});
+}
+
+//  stand-in for the GL buffer: copies uploads into host memory
+//
+class MockBackend : public StagingBackend {
+public:
+	void allocate(int capacity, int stride) { store.resize((size_t)capacity * stride); }
+	void orphan() {}
+	void upload(const void *data, int count, int stride) { memcpy(&store[0], data, (size_t)count * stride); }
+	vector<char> store;
+};
+
+static void benchStaging() {
+	const int n = 10000;
+	const int reps = 500;
+
+	ParticleSystem sys;
+	sys.append(n);
+
+	// the old loadVbo(): two fresh vectors rebuilt and copied every frame
+	//
+	vector<ofVec3f> store;
+	double rebuild = bench("loadVbo (rebuild vectors)", reps, n, [&]() {
+		vector<ofVec3f> sizes;
+		vector<ofVec3f> points;
+		for (int i = 0; i < sys.particles.size(); i++) {
+			points.push_back(sys.particles[i].position);
+			sizes.push_back(ofVec3f(50));
+		}
+		store.assign(points.begin(), points.end());
+		store.insert(store.end(), sizes.begin(), sizes.end());
+	});
+
+	MockBackend mock;
+	ParticleStaging staging;
+	staging.setBackend(&mock);
+	double staged = bench("ParticleStaging::update", reps, n, [&]() {
+		staging.update(sys.particles);
+	});
+	cout << "staging speedup: " << rebuild / staged << "x, allocations: " << staging.allocations
+		<< ", " << staging.bytesUploaded / ((double)reps * n) << " bytes/particle uploaded" << endl;
+}
+
+//  packing a system into the instance array for one instanced draw
+//
+static void benchBatch() {
+	for (int n : { 500, 10000 }) {
+		ParticleEmitter e;
+		e.setEmitterType(RadialEmitter);
+		e.spawnBatch(n, 0);
+		e.sys->time = 1;
+
+		ParticleBatch batch;
+		bench("ParticleBatch::pack (" + ofToString(n) + ")", 1000, n, [&]() {
+			batch.pack(*e.sys);
+		});
+	}
+}
+
+//  lander box vs. terrain: the old nearest leaf vertex test and the
+//  triangle narrow phase, on boxes scattered around the surface
+//
+static void benchContacts(Octree &octree, const string &suffix) {
+	NarrowPhase narrow;
+	narrow.setup(&octree);
+
+	const int n = 1000;
+	Box local(Vector3(-1, 0, -1), Vector3(1, 2, 1));
+	vector<OBB> boxes;
+	Random rng(7);
+	for (int i = 0; i < n; i++) {
+		ofVec3f pos = rng.inBox(ofVec3f(-90, -9, -90), ofVec3f(90, 9, 90));
+		boxes.push_back(OBB(local, pos, rng.uniform(0, 360)));
+	}
+
+	vector<TreeNode> nodeList;
+	int near = 0;
+	bench("nearest vertex (per box)" + suffix, 20, n, [&]() {
+		near = 0;
+		for (auto &b : boxes) {
+			nodeList.clear();
+			if (!octree.intersect(b.bounds(), octree.root, nodeList)) continue;
+			float closest = FLT_MAX;
+			for (auto &node : nodeList) {
+				closest = MIN(closest, b.center.distance(octree.mesh.getVertex(node.points[0])));
+			}
+			if (closest < 1) near++;
+		}
+	});
+
+	ContactManifold manifold;
+	long contacts = 0;
+	int touching = 0;
+	double ns = bench("narrow phase (per box)" + suffix, 20, n, [&]() {
+		contacts = 0;
+		touching = 0;
+		for (auto &b : boxes) {
+			int c = narrow.collide(b, manifold);
+			contacts += c;
+			if (c > 0) touching++;
+		}
+	});
+	cout << "boxes touching: nearest vertex " << near << ", narrow phase " << touching
+		<< ", " << contacts * 1e9 / (ns * n) << " contacts/s" << endl;
+}
+
+//  query rays from above the terrain, straight down and slanted, and
+//  lander sized query boxes around its surface
+//
+static void queryRays(const Box &bounds, int n, vector<Ray> &rays) {
+	Random rng(11);
+	Vector3 lo = bounds.parameters[0], hi = bounds.parameters[1];
+	for (int i = 0; i < n; i++) {
+		ofVec3f o = rng.inBox(ofVec3f(lo.x(), hi.y() + 10, lo.z()), ofVec3f(hi.x(), hi.y() + 50, hi.z()));
+		ofVec3f d = i % 2 ? ofVec3f(0, -1, 0) : ofVec3f(rng.uniform(-1, 1), -1, rng.uniform(-1, 1)).getNormalized();
+		rays.push_back(Ray(Vector3(o.x, o.y, o.z), Vector3(d.x, d.y, d.z)));
+	}
+}
+
+static void queryBoxes(const Box &bounds, int n, vector<Box> &boxes) {
+	Random rng(12);
+	Vector3 lo = bounds.parameters[0], hi = bounds.parameters[1];
+	for (int i = 0; i < n; i++) {
+		ofVec3f c = rng.inBox(ofVec3f(lo.x(), lo.y(), lo.z()), ofVec3f(hi.x(), hi.y(), hi.z()));
+		float s = rng.uniform(1, 3);
+		boxes.push_back(Box(Vector3(c.x - s, c.y - s, c.z - s), Vector3(c.x + s, c.y + s, c.z + s)));
+	}
+}
+
+//  building the octree and the three ways of querying it
+//
+static void benchOctree(const ofMesh &terrain, int levels, const string &suffix) {
+	int nv = terrain.getNumVertices();
+	Octree octree;
+	bench("Octree::create (per vertex)" + suffix, 3, nv, [&]() {
+		octree = Octree();
+		octree.create(terrain, levels);
+	});
+
+	const int n = 1000;
+	vector<Ray> rays;
+	queryRays(octree.root.box, n, rays);
+	TreeNode node;
+	bench("Octree::intersect ray (per ray)" + suffix, 5, n, [&]() {
+		long hits = 0;
+		for (auto &r : rays) hits += octree.intersect(r, octree.root, node);
+		benchSink = benchSink + hits;
+	});
+
+	vector<Box> boxes;
+	queryBoxes(octree.root.box, n, boxes);
+	vector<Box> boxList;
+	bench("Octree::intersect box->boxes (per box)" + suffix, 5, n, [&]() {
+		for (auto &b : boxes) {
+			boxList.clear();
+			octree.intersect(b, octree.root, boxList);
+			benchSink = benchSink + boxList.size();
+		}
+	});
+	vector<TreeNode> nodeList;
+	bench("Octree::intersect box->nodes (per box)" + suffix, 5, n, [&]() {
+		for (auto &b : boxes) {
+			nodeList.clear();
+			octree.intersect(b, octree.root, nodeList);
+			benchSink = benchSink + nodeList.size();
+		}
+	});
+	vector<int> points;
+	bench("Octree::intersect box->points (per box)" + suffix, 5, n, [&]() {
+		for (auto &b : boxes) {
+			points.clear();
+			octree.intersect(b, octree.root, points);
+			benchSink = benchSink + points.size();
+		}
+	});
+}
+
+//  the flattened octree with cell, 8 bit and 16 bit node bounds against
+//  the tree: size, box and ray query speed, and that the answers agree
+//
+static void benchCompact(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree;
+	octree.create(terrain, levels);
+	OctreeMemory m = octree.memory();
+	size_t treeBytes = m.nodeBytes + m.pointBytes;
+	cout << "Octree" << suffix << ": " << m.nodes << " nodes, " << treeBytes / 1024 << " KB, "
+		<< m.nodes * sizeof(Box) / 1024 << " KB of it node Boxes" << endl;
+
+	const int n = 1000;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	queryBoxes(octree.root.box, n, boxes);
+	queryRays(octree.root.box, n, rays);
+
+	vector<int> points;
+	double treeNs = bench("Octree box->points (per box)" + suffix, 5, n, [&]() {
+		for (auto &b : boxes) {
+			points.clear();
+			octree.intersect(b, octree.root, points);
+		}
+	});
+	TreeNode node;
+	double treeRayNs = bench("Octree ray (per ray)" + suffix, 5, n, [&]() {
+		for (auto &r : rays) octree.intersect(r, octree.root, node);
+	});
+
+	const char *names[] = { "cell bounds", "8 bit bounds", "16 bit bounds" };
+	for (int mode = 0; mode < 3; mode++) {
+		CompactOctree compact;
+		compact.build(octree, (CompactOctree::BoundsMode)mode);
+		string name = string("CompactOctree ") + names[mode];
+		cout << name << suffix << ": " << compact.bytes() / 1024 << " KB (" << (double)treeBytes / compact.bytes()
+			<< "x smaller), node bounds " << compact.boundsBytes() / 1024 << " KB" << endl;
+
+		double ns = bench(name + " box->points (per box)" + suffix, 5, n, [&]() {
+			for (auto &b : boxes) {
+				points.clear();
+				compact.intersect(b, points);
+			}
+		});
+		cout << "box query speedup: " << treeNs / ns << "x" << endl;
+
+		// cell bounds give the tree's answer exactly; tight bounds give a
+		// subset of it that still holds every point inside the box
+		//
+		int wrong = 0;
+		vector<int> expect;
+		for (auto &b : boxes) {
+			expect.clear();
+			points.clear();
+			octree.intersect(b, octree.root, expect);
+			compact.intersect(b, points);
+			sort(expect.begin(), expect.end());
+			sort(points.begin(), points.end());
+			if (mode == CompactOctree::CellBounds) {
+				if (points != expect) wrong++;
+				continue;
+			}
+			bool bOk = includes(expect.begin(), expect.end(), points.begin(), points.end());
+			for (int i : expect) {
+				if (b.inside(Vec4::of(octree.mesh.getVertices()[i])) && !binary_search(points.begin(), points.end(), i)) bOk = false;
+			}
+			if (!bOk) wrong++;
+		}
+
+		if (mode == CompactOctree::CellBounds) {
+			int point;
+			ns = bench(name + " ray (per ray)" + suffix, 5, n, [&]() {
+				for (auto &r : rays) compact.intersect(r, point);
+			});
+			cout << "ray query speedup: " << treeRayNs / ns << "x" << endl;
+			for (auto &r : rays) {
+				node = TreeNode();
+				bool hit = octree.intersect(r, octree.root, node) && node.points.size() == 1;
+				bool compactHit = compact.intersect(r, point);
+				if (hit != compactHit || (hit && node.points[0] != point)) wrong++;
+			}
+		}
+		cout << "queries that disagree with the tree: " << wrong << endl;
+	}
+}
+
+//  set associative LRU cache fed with the addresses a query reads, to
+//  count the misses it would take in a cache of the given size
+//
+class CacheModel {
+public:
+	CacheModel(int bytes, int ways = 8) {
+		this->ways = ways;
+		sets = bytes / (lineBytes * ways);
+		tags.assign(sets * ways, ~(uintptr_t)0);
+		misses = 0;
+	}
+
+	void read(const void *p) {
+		uintptr_t line = (uintptr_t)p / lineBytes;
+		uintptr_t *set = &tags[(line % sets) * ways];
+		int i = 0;
+		while (i < ways && set[i] != line) i++;
+		if (i == ways) {
+			misses++;
+			i = ways - 1;
+		}
+		for (; i > 0; i--) set[i] = set[i - 1];     // most recent first
+		set[0] = line;
+	}
+
+	static const int lineBytes = 64;
+	int ways, sets;
+	vector<uintptr_t> tags;
+	long misses;
+};
+
+//  L1 data and last level cache read misses of this thread from the
+//  hardware counters, where the OS lets us read them (Linux perf)
+//
+class CacheCounters {
+public:
+	CacheCounters() {
+		fd[0] = fd[1] = -1;
+#ifdef __linux__
+		uint64_t configs[2] = {
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+		};
+		for (int i = 0; i < 2; i++) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = configs[i];
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+#endif
+	}
+	~CacheCounters() {
+#ifdef __linux__
+		for (int i = 0; i < 2; i++) if (fd[i] >= 0) close(fd[i]);
+#endif
+	}
+
+	bool available() const { return fd[0] >= 0 || fd[1] >= 0; }
+
+	// counts so far, -1 where there is no counter
+	//
+	void read(long long counts[2]) const {
+		for (int i = 0; i < 2; i++) {
+			counts[i] = -1;
+#ifdef __linux__
+			if (fd[i] >= 0 && ::read(fd[i], &counts[i], sizeof(counts[i])) != sizeof(counts[i])) counts[i] = -1;
+#endif
+		}
+	}
+
+	int fd[2];
+};
+
+//  the compact octree's node orders, with and without prefetching, on
+//  box and ray queries: time, hardware cache misses where available,
+//  and misses in a 32 KB and a 1 MB cache model (from trace())
+//
+static void benchOrder(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree;
+	octree.create(terrain, levels);
+	const int n = 1000;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	queryBoxes(octree.root.box, n, boxes);
+	queryRays(octree.root.box, n, rays);
+
+	CacheCounters hw;
+	if (!hw.available()) cout << "hardware cache counters unavailable, cache model only" << endl;
+	const char *modeNames[] = { "cell bounds", "8 bit bounds" };
+	const char *orderNames[] = { "depth first", "breadth first", "van Emde Boas" };
+
+	for (int mode = 0; mode < 2; mode++) {
+		CompactOctree reference;
+		reference.build(octree, (CompactOctree::BoundsMode)mode);
+		for (int order = 0; order < 3; order++) {
+			CompactOctree compact;
+			compact.build(octree, (CompactOctree::BoundsMode)mode);
+			compact.reorder((CompactOctree::NodeOrder)order);
+			string name = string("CompactOctree ") + modeNames[mode] + ", " + orderNames[order];
+
+			vector<int> points;
+			int point;
+			for (int fetch = 0; fetch < 2; fetch++) {
+				compact.prefetch = fetch;
+				string label = name + (fetch ? ", prefetch" : "");
+				const int reps = 20;
+				long long c1[2], c2[2];
+				auto misses = [&](int items) {
+					if (!hw.available()) return;
+					cout << "  L1D misses/query " << (c1[0] < 0 ? -1.0 : (double)(c2[0] - c1[0]) / items)
+						<< ", LLC misses/query " << (c1[1] < 0 ? -1.0 : (double)(c2[1] - c1[1]) / items) << endl;
+				};
+				hw.read(c1);
+				bench(label + " box (per box)" + suffix, reps, n, [&]() {
+					for (auto &b : boxes) {
+						points.clear();
+						compact.intersect(b, points);
+					}
+				});
+				hw.read(c2);
+				misses(reps * n);
+				hw.read(c1);
+				bench(label + " ray (per ray)" + suffix, reps, n, [&]() {
+					for (auto &r : rays) compact.intersect(r, point);
+				});
+				hw.read(c2);
+				misses(reps * n);
+			}
+
+			// the same reads in either prefetch setting, so one model run
+			//
+			vector<const void *> reads;
+			for (int ray = 0; ray < 2; ray++) {
+				CacheModel small(32 << 10), large(1 << 20);
+				for (int i = 0; i < n; i++) {
+					reads.clear();
+					if (ray) compact.trace(rays[i], reads);
+					else compact.trace(boxes[i], reads);
+					for (const void *p : reads) {
+						small.read(p);
+						large.read(p);
+					}
+				}
+				string what = ray ? " ray" : " box";
+				cout << name << what << " model misses/query: 32 KB " << (double)small.misses / n
+					<< ", 1 MB " << (double)large.misses / n << endl;
+				counters.push_back({ name + what + " 32 KB model misses" + suffix, (double)small.misses });
+				counters.push_back({ name + what + " 1 MB model misses" + suffix, (double)large.misses });
+			}
+
+			int wrong = 0;
+			vector<int> expect;
+			for (int i = 0; i < n; i++) {
+				expect.clear();
+				points.clear();
+				reference.intersect(boxes[i], expect);
+				compact.intersect(boxes[i], points);
+				int expectPoint;
+				bool expectHit = reference.intersect(rays[i], expectPoint);
+				if (points != expect || compact.intersect(rays[i], point) != expectHit || (expectHit && point != expectPoint)) {
+					wrong++;
+				}
+			}
+			cout << "queries that disagree with depth first: " << wrong << endl;
+		}
+	}
+}
+
+//  rays from outside the terrain across it at a shallow downward angle
+//  (horizon checks), "grazing" between 1 and 10 degrees or "horizon"
+//  between 0 and 1
+//
+static void shallowRays(const Box &bounds, int n, float minAngle, float maxAngle, vector<Ray> &rays) {
+	Random rng(14);
+	Vector3 lo = bounds.parameters[0], hi = bounds.parameters[1];
+	ofVec3f center = ofVec3f(lo.x() + hi.x(), lo.y() + hi.y(), lo.z() + hi.z()) / 2;
+	float radius = (hi.x() - lo.x()) * 0.75;
+	for (int i = 0; i < n; i++) {
+		float heading = rng.uniform(0, TWO_PI);
+		float drop = ofDegToRad(rng.uniform(minAngle, maxAngle));
+		ofVec3f o = center + ofVec3f(cos(heading) * radius, 0, sin(heading) * radius);
+		o.y = rng.uniform(center.y, hi.y() + 5);
+		float across = heading + ofDegToRad(rng.uniform(-20, 20));
+		ofVec3f d = ofVec3f(-cos(across) * cos(drop), -sin(drop), -sin(across) * cos(drop));
+		rays.push_back(Ray(toVector3(o), toVector3(d)));
+	}
+}
+
+//  where the ray enters the box (0 if it starts inside)
+//
+static float entry(const Box &box, const Ray &r) {
+	float t = 0;
+	for (int k = 0; k < 3; k++) {
+		if (r.direction[k] != 0) t = MAX(t, (box.parameters[r.sign[k]][k] - r.origin[k]) * r.inv_direction[k]);
+	}
+	return t;
+}
+
+//  rope traversal (nearest leaf, leaf to leaf) against the recursive
+//  queries (every leaf the ray crosses) on shallow and straight down
+//  rays, and that it finds the nearest one point leaf the recursive
+//  traversal crosses
+//
+static void benchRopes(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree;
+	octree.create(terrain, levels);
+	CompactOctree compact;
+	compact.build(octree);
+	size_t plain = compact.bytes();
+	compact.buildRopes();
+	cout << "CompactOctree ropes" << suffix << ": " << (compact.bytes() - plain) / 1024 << " KB" << endl;
+
+	const int n = 1000;
+	vector<Ray> grazing, horizon, down, all;
+	shallowRays(octree.root.box, n, 1, 10, grazing);
+	shallowRays(octree.root.box, n, 0, 1, horizon);
+	queryRays(octree.root.box, n, all);
+	for (int i = 1; i < n; i += 2) down.push_back(all[i]);
+
+	const char *names[] = { "grazing", "horizon", "straight down" };
+	vector<Ray> *sets[] = { &grazing, &horizon, &down };
+	for (int s = 0; s < 3; s++) {
+		vector<Ray> &rays = *sets[s];
+		string what = string(" ") + names[s] + " (per ray)" + suffix;
+		TreeNode node;
+		int point;
+		long hits = 0;
+		bench("Octree::intersect" + what, 5, rays.size(), [&]() {
+			for (auto &r : rays) octree.intersect(r, octree.root, node);
+		});
+		double recursive = bench("CompactOctree::intersect" + what, 5, rays.size(), [&]() {
+			for (auto &r : rays) compact.intersect(r, point);
+		});
+		double rope = bench("CompactOctree::intersectNearest" + what, 5, rays.size(), [&]() {
+			hits = 0;
+			for (auto &r : rays) hits += compact.intersectNearest(r, point);
+		});
+		cout << "rope speedup: " << recursive / rope << "x, " << hits << " of " << rays.size() << " rays hit" << endl;
+
+		// the nearest entry among the one point leaves the recursive query
+		// reads, against the entry of the leaf the ropes found
+		//
+		int wrong = 0;
+		vector<const void *> reads;
+		for (auto &r : rays) {
+			reads.clear();
+			compact.trace(r, reads);
+			float best = FLT_MAX, found = FLT_MAX;
+			bool hit = compact.intersectNearest(r, point);
+			for (const void *p : reads) {
+				int leaf = (const CompactNode *)p - &compact.nodes[0];
+				const CompactNode &c = compact.nodes[leaf];
+				if (!c.isLeaf() || c.count() != 1) continue;
+				float t = entry(compact.cells[leaf], r);
+				best = MIN(best, t);
+				if (hit && compact.points[c.first] == point) found = MIN(found, t);
+			}
+			if (hit != (best < FLT_MAX) || (hit && found > best + 1e-3f * (1 + best))) wrong++;
+		}
+		cout << "rays where the ropes miss the nearest leaf: " << wrong << endl;
+	}
+}
+
+//  the per-frame lander queries along a descent that drifts across the
+//  terrain a couple of centimeters per frame: the collision box and the
+//  altitude ray from the root every time, then through CoherentQuery
+//
+static void benchCoherent(const Octree &octree, const string &suffix) {
+	const int frames = 3000;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	for (int i = 0; i < frames; i++) {
+		float s = (float)i / frames;
+		ofVec3f p(-20 + 40 * s, 20 - 22 * s, 10 * sin(s * 3));
+		ofVec3f h(2, 1.5, 2);
+		boxes.push_back(Box(toVector3(p - h), toVector3(p + h)));
+		rays.push_back(Ray(toVector3(p), Vector3(0, -1, 0)));
+	}
+
+	for (int coherent = 0; coherent < 2; coherent++) {
+		CoherentQuery boxQuery, rayQuery;
+		boxQuery.setup(&octree);
+		rayQuery.setup(&octree);
+		boxQuery.bEnabled = rayQuery.bEnabled = coherent;
+		string how = coherent ? "coherent" : "from the root";
+		vector<int> points;
+		bench("collision box query, " + how + suffix, 1, frames, [&]() {
+			for (auto &b : boxes) {
+				points.clear();
+				boxQuery.intersect(b, points);
+			}
+		});
+		int point;
+		float t;
+		bench("altitude ray query, " + how + suffix, 1, frames, [&]() {
+			for (auto &r : rays) rayQuery.intersectNearest(r, point, t);
+		});
+		for (CoherentQuery *q : { &boxQuery, &rayQuery }) {
+			cout << "  " << (q == &boxQuery ? "box" : "ray") << ": " << q->stats.nodesPerQuery() << " nodes/query, "
+				<< q->stats.hitRate() * 100 << "% from the window, " << q->stats.reused * 100.0 / q->stats.queries
+				<< "% last answer" << endl;
+			counters.push_back({ string(q == &boxQuery ? "box" : "ray") + " query nodes per 1000, " + how + suffix,
+				q->stats.nodesPerQuery() * 1000 });
+		}
+	}
+
+	// the same answers both ways, frame by frame
+	//
+	CoherentQuery fresh, coherent;
+	fresh.setup(&octree);
+	coherent.setup(&octree);
+	fresh.bEnabled = false;
+	int wrong = 0;
+	vector<int> expect, points;
+	for (int i = 0; i < frames; i++) {
+		expect.clear();
+		points.clear();
+		fresh.intersect(boxes[i], expect);
+		coherent.intersect(boxes[i], points);
+		int p1, p2;
+		float t1, t2;
+		bool h1 = fresh.intersectNearest(rays[i], p1, t1);
+		bool h2 = coherent.intersectNearest(rays[i], p2, t2);
+		if (points != expect || h1 != h2 || (h1 && (p1 != p2 || t1 != t2))) wrong++;
+	}
+	cout << "frames where the coherent answers differ: " << wrong << endl;
+}
+
+//  what the octree holds at each terrain size
+//
+static void benchMemory(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree;
+	octree.create(terrain, levels);
+	OctreeMemory m = octree.memory();
+	cout << "memory" << suffix << ":" << endl;
+	m.print(cout);
+	cout << "  stray vertices " << octree.strayVerts << endl;
+
+	counters.push_back({ "octree nodes" + suffix, (double)m.nodes });
+	counters.push_back({ "octree leaves" + suffix, (double)m.leaves });
+	counters.push_back({ "octree depth" + suffix, (double)m.depthNodes.size() });
+	counters.push_back({ "octree node bytes" + suffix, (double)m.nodeBytes });
+	counters.push_back({ "octree point bytes" + suffix, (double)m.pointBytes });
+	counters.push_back({ "octree mesh bytes" + suffix, (double)m.meshBytes });
+}
+
+//  lazy against eager construction: build time, then query latency over
+//  rounds of new queries while the lazy tree fills in, the answers of
+//  the two trees, and the same queries from several threads at once on a
+//  fresh lazy tree
+//
+static void benchLazy(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree eager, lazy;
+	bench("Octree::create eager (per build)" + suffix, 3, 1, [&]() {
+		eager = Octree();
+		eager.create(terrain, levels);
+	});
+	bench("Octree::create lazy (per build)" + suffix, 3, 1, [&]() {
+		lazy = Octree();
+		lazy.bLazy = true;
+		lazy.create(terrain, levels);
+	});
+	int eagerNodes = eager.memory().nodes;
+	cout << "lazy tree after create: " << lazy.memory().nodes << " of " << eagerNodes << " nodes" << endl;
+
+	const int n = 1000;
+	const int rounds = 6;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	queryBoxes(eager.root.box, n * rounds, boxes);
+	queryRays(eager.root.box, n * rounds, rays);
+
+	// one round: n boxes and n rays, ns per query
+	//
+	vector<int> points, expect;
+	TreeNode node, expectNode;
+	auto round = [&](Octree &tree, int r) {
+		auto t1 = chrono::steady_clock::now();
+		for (int i = r * n; i < (r + 1) * n; i++) {
+			points.clear();
+			tree.intersect(boxes[i], tree.root, points);
+			tree.intersect(rays[i], tree.root, node);
+		}
+		auto t2 = chrono::steady_clock::now();
+		return chrono::duration<double, nano>(t2 - t1).count() / (2 * n);
+	};
+	for (int r = 0; r < rounds; r++) {
+		double lazyNs = round(lazy, r);
+		double eagerNs = round(eager, r);
+		cout << "  round " << r + 1 << ": lazy " << lazyNs << " ns/query, eager " << eagerNs << " ns/query, lazy tree "
+			<< lazy.memory().nodes << " nodes" << endl;
+	}
+	bench("lazy tree query, steady state (per query)" + suffix, 5, 2 * n, [&]() { round(lazy, 0); });
+	bench("eager tree query (per query)" + suffix, 5, 2 * n, [&]() { round(eager, 0); });
+
+	int wrong = 0;
+	for (int i = 0; i < n * rounds; i++) {
+		points.clear();
+		expect.clear();
+		lazy.intersect(boxes[i], lazy.root, points);
+		eager.intersect(boxes[i], eager.root, expect);
+		bool h1 = lazy.intersect(rays[i], lazy.root, node);
+		bool h2 = eager.intersect(rays[i], eager.root, expectNode);
+		if (points != expect || h1 != h2 || (h1 && node.points != expectNode.points)) wrong++;
+	}
+	cout << "queries where lazy and eager differ: " << wrong << endl;
+
+	// threads expanding the same nodes at the same time
+	//
+	Octree shared;
+	shared.bLazy = true;
+	shared.create(terrain, levels);
+	const int nThreads = 4;
+	vector<int> threadWrong(nThreads, 0);
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++) {
+		threads.push_back(thread([&, t]() {
+			vector<int> p, e;
+			for (int i = 0; i < n; i++) {
+				int k = (i + t * n / nThreads) % n;
+				p.clear();
+				e.clear();
+				shared.intersect(boxes[k], shared.root, p);
+				eager.intersect(boxes[k], eager.root, e);
+				if (p != e) threadWrong[t]++;
+			}
+		}));
+	}
+	for (auto &t : threads) t.join();
+	int total = 0;
+	for (int w : threadWrong) total += w;
+	OctreeMemory m = shared.memory();
+	cout << nThreads << " threads on a fresh lazy tree: " << total << " wrong answers, " << m.nodes << " nodes, "
+		<< m.unbuilt << " not expanded" << endl;
+
+	// fully expanded, it is the eager tree
+	//
+	CompactOctree compact;
+	compact.build(lazy);
+	cout << "lazy tree expanded out: " << lazy.memory().nodes << " nodes, leaves " << lazy.numLeaf << " / "
+		<< eager.numLeaf << ", stray vertices " << lazy.strayVerts << " / " << eager.strayVerts << endl;
+}
+
+//  run f(thread index) on "n" threads and wait for them
+//
+template <class F>
+static void onThreads(int n, F f) {
+	vector<thread> threads;
+	for (int t = 0; t < n; t++) threads.push_back(thread(f, t));
+	for (auto &t : threads) t.join();
+}
+
+//  one octree serving many threads: a stress run where every thread
+//  queries the same eager tree, a fresh lazy tree and a CompactOctree
+//  (and its own CoherentQuery) and checks each answer against the
+//  single threaded one, then aggregate query throughput by thread count
+//
+static void benchThreads(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree, lazy;
+	octree.create(terrain, levels);
+	lazy.bLazy = true;
+	lazy.create(terrain, levels);
+	CompactOctree compact;
+	compact.build(octree);
+
+	const int n = 2000;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	queryBoxes(octree.root.box, n, boxes);
+	queryRays(octree.root.box, n, rays);
+
+	// single threaded answers
+	//
+	vector<vector<int>> boxExpect(n);
+	vector<int> rayExpect(n, -1);
+	vector<int> nodeExpect(n);
+	for (int i = 0; i < n; i++) {
+		octree.intersect(boxes[i], octree.root, boxExpect[i]);
+		TreeNode node;
+		if (octree.intersect(rays[i], octree.root, node) && node.points.size() == 1) rayExpect[i] = node.points[0];
+		vector<TreeNode> nodes;
+		octree.intersect(boxes[i], octree.root, nodes);
+		nodeExpect[i] = nodes.size();
+	}
+
+	// a path of small steps for the coherent queries, like a lander's
+	//
+	vector<Box> path;
+	Vector3 lo = octree.root.box.parameters[0], hi = octree.root.box.parameters[1];
+	for (int i = 0; i < n; i++) {
+		float s = (float)i / n;
+		Vector3 c(lo.x() + (hi.x() - lo.x()) * s, (lo.y() + hi.y()) / 2, lo.z() + (hi.z() - lo.z()) * (0.5f + 0.4f * sin(s * 6)));
+		path.push_back(Box(c - Vector3(1, 1, 1), c + Vector3(1, 1, 1)));
+	}
+	vector<vector<int>> pathExpect(n);
+	for (int i = 0; i < n; i++) octree.intersect(path[i], octree.root, pathExpect[i]);
+
+	int maxThreads = MAX((int)thread::hardware_concurrency(), 4);
+	atomic<long> wrong(0), checked(0);
+	auto t1 = chrono::steady_clock::now();
+	onThreads(maxThreads, [&](int t) {
+		CoherentQuery coherent;
+		coherent.setup(&octree);
+		vector<int> points;
+		vector<TreeNode> nodes;
+		long bad = 0, count = 0;
+		for (int pass = 0; pass < 3; pass++) {
+			for (int j = 0; j < n; j++) {
+				int i = (j * 7 + t * 131 + pass) % n;     // a different order on every thread
+				const Octree &tree = (j & 1) ? lazy : octree;
+				points.clear();
+				tree.intersect(boxes[i], tree.root, points);
+				bad += points != boxExpect[i];
+				int p = -1;
+				TreeNode node;      // keeps its old value when no leaf is hit
+				if (tree.intersect(rays[i], tree.root, node) && node.points.size() == 1) p = node.points[0];
+				bad += p != rayExpect[i];
+				nodes.clear();
+				tree.intersect(boxes[i], tree.root, nodes);
+				bad += (int)nodes.size() != nodeExpect[i];
+
+				points.clear();
+				compact.intersect(boxes[i], points);
+				sort(points.begin(), points.end());
+				vector<int> expect = boxExpect[i];
+				sort(expect.begin(), expect.end());
+				bad += points != expect;
+
+				points.clear();
+				coherent.intersect(path[j], points);
+				bad += points != pathExpect[j];
+				count += 5;
+			}
+		}
+		wrong += bad;
+		checked += count;
+	});
+	auto t2 = chrono::steady_clock::now();
+	cout << "stress" << suffix << ": " << maxThreads << " threads, " << checked << " answers checked, " << wrong
+		<< " wrong, " << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+
+	// the same total work spread over 1, 2, 4 ... threads
+	//
+	const int passes = 8;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		string name = "Octree box + ray queries, " + ofToString(threads) + " threads (per query)" + suffix;
+		vector<long> sums(threads, 0);
+		bench(name, 1, passes * n * 2, [&]() {
+			onThreads(threads, [&](int t) {
+				vector<int> points;
+				TreeNode node;
+				long sum = 0;
+				for (int k = t; k < passes * n; k += threads) {
+					int i = k % n;
+					points.clear();
+					octree.intersect(boxes[i], octree.root, points);
+					sum += points.size() + octree.intersect(rays[i], octree.root, node);
+				}
+				sums[t] = sum;
+			});
+		});
+		for (long s : sums) benchSink = benchSink + s;
+	}
+	cout << "(" << thread::hardware_concurrency() << " hardware threads)" << endl;
+}
+
+//  batch queries on a WorkPool: that they give the one at a time
+//  answers, Morton sorting on and off, chunk sizes, and throughput from
+//  1 thread to one per core
+//
+static void benchParallel(const ofMesh &terrain, int levels, const string &suffix) {
+	Octree octree;
+	octree.create(terrain, levels);
+	const int n = 100000;
+	vector<Box> boxes;
+	vector<Ray> rays;
+	queryBoxes(octree.root.box, n, boxes);
+	queryRays(octree.root.box, n, rays);
+
+	int maxThreads = MAX((int)thread::hardware_concurrency(), 4);
+	WorkPool pool(maxThreads);
+	OctreeBatch batch;
+	batch.setup(&octree, &pool);
+	vector<int> points, first, hits;
+	vector<float> ts;
+
+	// one at a time, in order
+	//
+	CoherentQuery single;
+	single.setup(&octree);
+	single.bEnabled = false;
+	vector<int> expect, expectFirst(1, 0), expectHits(n, -1);
+	vector<float> expectTs(n, 0);
+	for (int i = 0; i < n; i++) {
+		octree.intersect(boxes[i], octree.root, expect);
+		expectFirst.push_back(expect.size());
+		single.intersectNearest(rays[i], expectHits[i], expectTs[i]);
+	}
+	batch.intersect(boxes, points, first);
+	batch.intersectNearest(rays, hits, ts);
+	bool bSame = points == expect && first == expectFirst && hits == expectHits;
+	for (int i = 0; i < n && bSame; i++) bSame = hits[i] < 0 || ts[i] == expectTs[i];
+	cout << "batch answers" << suffix << (bSame ? " match" : " DIFFER from") << " the single queries" << endl;
+
+	for (int sorted = 0; sorted < 2; sorted++) {
+		batch.bSort = sorted;
+		string how = sorted ? "Morton order" : "given order";
+		for (int chunk : { 16, 64, 256, 1024 }) {
+			batch.chunk = chunk;
+			string name = ", " + how + ", chunk " + ofToString(chunk) + " (per query)" + suffix;
+			bench("batch boxes" + name, 3, n, [&]() { batch.intersect(boxes, points, first); });
+			bench("batch rays" + name, 3, n, [&]() { batch.intersectNearest(rays, hits, ts); });
+		}
+	}
+
+	batch.bSort = true;
+	batch.chunk = 64;
+	long steals = pool.steals;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		WorkPool some(threads);
+		batch.setup(&octree, &some);
+		string name = ", " + ofToString(threads) + " threads (per query)" + suffix;
+		bench("batch boxes" + name, 3, n, [&]() { batch.intersect(boxes, points, first); });
+		bench("batch rays" + name, 3, n, [&]() { batch.intersectNearest(rays, hits, ts); });
+		steals += some.steals;
+	}
+	cout << "(" << thread::hardware_concurrency() << " hardware threads, " << steals << " ranges stolen)" << endl;
+}
+
+//  one instantiation of OctreeT: what it holds and its box->points speed
+//
+template <class Tree>
+static void benchInstance(const string &name, const ofMesh &mesh, int levels, const vector<Box> &boxes,
+	const vector<vector<int>> &expect, const string &suffix)
+{
+	Tree tree;
+	tree.create(mesh, levels);
+	OctreeMemory m = tree.memory();
+	cout << name << suffix << ": " << m.nodes << " nodes (" << sizeof(typename Tree::TreeNode) << " bytes), node records "
+		<< m.nodeBytes / 1024 << " KB, point lists " << m.pointBytes / 1024 << " KB, together "
+		<< (m.nodeBytes + m.pointBytes) / 1024 << " KB" << endl;
+	counters.push_back({ name + " node bytes" + suffix, (double)m.nodeBytes });
+	counters.push_back({ name + " point bytes" + suffix, (double)m.pointBytes });
+
+	// leaves of several points can add points outside the box, but
+	// every point the one point leaves give must be there
+	//
+	decltype(tree.root.points) points;
+	int wrong = 0;
+	long extra = 0;
+	for (int i = 0; i < boxes.size(); i++) {
+		points.clear();
+		tree.intersect(boxes[i], tree.root, points);
+		vector<int> got(points.begin(), points.end());
+		sort(got.begin(), got.end());
+		wrong += !includes(got.begin(), got.end(), expect[i].begin(), expect[i].end());
+		extra += got.size() - expect[i].size();
+	}
+	cout << "  boxes missing points: " << wrong << ", extra points per box " << (double)extra / boxes.size() << endl;
+	bench(name + " box->points (per box)" + suffix, 20, boxes.size(), [&]() {
+		for (auto &b : boxes) {
+			points.clear();
+			tree.intersect(b, tree.root, points);
+			benchSink = benchSink + points.size();
+		}
+	});
+}
+
+//  OctreeT instantiations on meshes the size of lander parts: 32 and 16
+//  bit point indices, one and eight points a leaf, and the recursive
+//  box->points walk (as CoherentQuery does it from the root) against
+//  the template's stack loop
+//
+static void benchTemplate(int levels) {
+	for (int res : { 40, 80, 160 }) {
+		string suffix = " [" + ofToString(res * res) + " vertices]";
+		ofMesh mesh;
+		Terrain::heightfield(mesh, 200, res);
+
+		Octree octree;
+		octree.create(mesh, levels);
+		const int n = 1000;
+		vector<Box> boxes;
+		queryBoxes(octree.root.box, n, boxes);
+		vector<vector<int>> expect(n);
+		for (int i = 0; i < n; i++) {
+			octree.intersect(boxes[i], octree.root, expect[i]);
+			sort(expect[i].begin(), expect[i].end());
+		}
+
+		CoherentQuery recursive;
+		recursive.setup(&octree);
+		recursive.bEnabled = false;
+		vector<int> points;
+		bench("recursive box->points (per box)" + suffix, 20, n, [&]() {
+			for (auto &b : boxes) {
+				points.clear();
+				recursive.intersect(b, points);
+				benchSink = benchSink + points.size();
+			}
+		});
+		benchInstance<Octree>("Octree", mesh, levels, boxes, expect, suffix);
+		benchInstance<PartOctree>("PartOctree", mesh, levels, boxes, expect, suffix);
+		benchInstance<OctreeT<uint16_t, 8, 16>>("OctreeT<uint16_t, 8>", mesh, levels, boxes, expect, suffix);
+	}
+}
+
+//  every voxel a ray crosses, one by one, asking occupied() at its
+//  center: the answer VoxelOctree::intersect() should give
+//
+static bool marchVoxels(const VoxelOctree &voxels, const Ray &r, float &tRtn) {
+	int n = voxels.side();
+	float tIn = 0, tOut = FLT_MAX;
+	for (int k = 0; k < 3; k++) {
+		float a = (voxels.origin[k] - r.origin[k]) * r.inv_direction[k];
+		float b = (voxels.origin[k] + n * voxels.voxel - r.origin[k]) * r.inv_direction[k];
+		tIn = fmax(tIn, fmin(a, b));
+		tOut = fmin(tOut, fmax(a, b));
+	}
+	if (tIn > tOut) return false;
+
+	int c[3], step[3];
+	float tMax[3], tDelta[3];
+	Vector3 p = r.origin + r.direction * tIn;
+	for (int k = 0; k < 3; k++) {
+		c[k] = MIN(MAX((int)floor((p[k] - voxels.origin[k]) / voxels.voxel), 0), n - 1);
+		step[k] = r.direction[k] > 0 ? 1 : -1;
+		float next = voxels.origin[k] + (c[k] + (step[k] > 0)) * voxels.voxel;
+		tMax[k] = r.direction[k] != 0 ? (next - r.origin[k]) * r.inv_direction[k] : FLT_MAX;
+		tDelta[k] = r.direction[k] != 0 ? voxels.voxel * fabs(r.inv_direction[k]) : FLT_MAX;
+	}
+	float t = tIn;
+	for (;;) {
+		Vector3 center = voxels.origin + Vector3(c[0] + 0.5f, c[1] + 0.5f, c[2] + 0.5f) * voxels.voxel;
+		if (voxels.occupied(center)) {
+			tRtn = t;
+			return true;
+		}
+		int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+		t = MAX(t, tMax[axis]);
+		c[axis] += step[axis];
+		tMax[axis] += tDelta[axis];
+		if (t > tOut || c[axis] < 0 || c[axis] >= n) return false;
+	}
+}
+
+//  the voxel octree: build time and size, its queries checked against
+//  the definition (every triangle in occupied voxels, box and ray
+//  answers voxel by voxel) and timed, then as the narrow phase's broad
+//  phase: boxes it turns away that the triangle tests would have found
+//  touching (must be none), how many it turns away, and what that saves
+//
+static void benchVoxels(const ofMesh &terrain, int levels, const string &suffix) {
+	int nv = terrain.getNumVertices();
+	VoxelOctree voxels;
+	bench("VoxelOctree::build (per vertex)" + suffix, 3, nv, [&]() { voxels.build(terrain); });
+	cout << "  " << voxels.side() << "^3 voxels, " << voxels.nodes.size() << " nodes, " << voxels.bricks.size()
+		<< " bricks, " << voxels.bytes() << " bytes" << endl;
+	counters.push_back({ "voxel nodes" + suffix, (double)voxels.nodes.size() });
+	counters.push_back({ "voxel bricks" + suffix, (double)voxels.bricks.size() });
+	counters.push_back({ "voxel bytes" + suffix, (double)voxels.bytes() });
+
+	// points on every triangle are occupied
+	//
+	Random rng(15);
+	const glm::vec3 *verts = terrain.getVerticesPointer();
+	int missed = 0;
+	for (int t = 0; t + 2 < terrain.getNumIndices(); t += 3) {
+		ofVec3f a = verts[terrain.getIndex(t)], b = verts[terrain.getIndex(t + 1)], c = verts[terrain.getIndex(t + 2)];
+		for (int s = 0; s < 4; s++) {
+			float u = rng.uniform(0, 1), v = rng.uniform(0, 1);
+			if (u + v > 1) {
+				u = 1 - u;
+				v = 1 - v;
+			}
+			if (!voxels.occupied(toVector3(a + (b - a) * u + (c - a) * v))) missed++;
+		}
+	}
+
+	// box and ray answers against the voxels one by one
+	//
+	const int n = 1000;
+	Box bounds = Octree::meshBounds(terrain);
+	vector<Box> boxes;
+	queryBoxes(bounds, n, boxes);
+	int wrongBoxes = 0;
+	for (auto &b : boxes) {
+		int lo[3], hi[3];
+		for (int k = 0; k < 3; k++) {
+			lo[k] = MAX((int)floor((b.parameters[0][k] - voxels.origin[k]) / voxels.voxel), 0);
+			hi[k] = MIN((int)floor((b.parameters[1][k] - voxels.origin[k]) / voxels.voxel), voxels.side() - 1);
+		}
+		bool bEmpty = true;
+		for (int z = lo[2]; z <= hi[2] && bEmpty; z++) {
+			for (int y = lo[1]; y <= hi[1] && bEmpty; y++) {
+				for (int x = lo[0]; x <= hi[0] && bEmpty; x++) {
+					Vector3 center = voxels.origin + Vector3(x + 0.5f, y + 0.5f, z + 0.5f) * voxels.voxel;
+					if (voxels.occupied(center)) bEmpty = false;
+				}
+			}
+		}
+		if (bEmpty != voxels.empty(b)) wrongBoxes++;
+	}
+	vector<Ray> rays;
+	queryRays(bounds, n, rays);
+	shallowRays(bounds, n, 1, 10, rays);
+	int wrongRays = 0;
+	for (auto &r : rays) {
+		float t1 = 0, t2 = 0;
+		bool h1 = marchVoxels(voxels, r, t1);
+		bool h2 = voxels.intersect(r, t2);
+		if (h1 != h2 || (h1 && fabs(t1 - t2) > voxels.voxel * 0.01f)) wrongRays++;
+	}
+	cout << "triangle points in free voxels: " << missed << ", wrong box answers: " << wrongBoxes
+		<< ", wrong ray answers: " << wrongRays << endl;
+
+	// the queries against the octree's
+	//
+	Octree octree;
+	octree.create(terrain, levels);
+	vector<int> points;
+	bench("Octree::intersect box->points (per box)" + suffix, 5, n, [&]() {
+		for (auto &b : boxes) {
+			points.clear();
+			octree.intersect(b, octree.root, points);
+			benchSink = benchSink + points.size();
+		}
+	});
+	bench("VoxelOctree::empty (per box)" + suffix, 5, n, [&]() {
+		long free = 0;
+		for (auto &b : boxes) free += voxels.empty(b);
+		benchSink = benchSink + free;
+	});
+	bench("VoxelOctree::occupied (per point)" + suffix, 5, n, [&]() {
+		long full = 0;
+		for (auto &b : boxes) full += voxels.occupied(b.center());
+		benchSink = benchSink + full;
+	});
+	TreeNode node;
+	bench("Octree::intersect ray (per ray)" + suffix, 5, rays.size(), [&]() {
+		long hits = 0;
+		for (auto &r : rays) hits += octree.intersect(r, octree.root, node);
+		benchSink = benchSink + hits;
+	});
+	bench("VoxelOctree::intersect (per ray)" + suffix, 5, rays.size(), [&]() {
+		long hits = 0;
+		float t;
+		for (auto &r : rays) hits += voxels.intersect(r, t);
+		benchSink = benchSink + hits;
+	});
+
+	// lander boxes from inside the hills to just over the highest ones
+	// (higher up the octree's root box turns them away already), through
+	// the narrow phase with and without the voxels in front
+	//
+	Box local(Vector3(-1, 0, -1), Vector3(1, 2, 1));
+	vector<OBB> landers;
+	for (int i = 0; i < n; i++) {
+		ofVec3f pos(rng.uniform(-90, 90), rng.uniform(-9, 9), rng.uniform(-90, 90));
+		landers.push_back(OBB(local, pos, rng.uniform(0, 360)));
+	}
+	NarrowPhase narrow;
+	narrow.setup(&octree);
+	ContactManifold manifold;
+	int violations = 0, rejected = 0;
+	for (auto &b : landers) {
+		Box q = b.bounds();
+		Vector3 s(narrow.skin, narrow.skin, narrow.skin);
+		bool bEmpty = voxels.empty(Box(q.parameters[0] - s, q.parameters[1] + s));
+		int c = narrow.collide(b, manifold);
+		if (bEmpty) rejected++;
+		if (bEmpty && c > 0) violations++;
+	}
+	cout << "broad phase: " << rejected * 100.0 / n << "% of lander boxes turned away, "
+		<< violations << " of them touching" << endl;
+	counters.push_back({ "voxel broad phase rejects per 1000" + suffix, rejected * 1000.0 / n });
+
+	for (int with = 0; with < 2; with++) {
+		narrow.voxels = with ? &voxels : NULL;
+		bench(string("narrow phase, ") + (with ? "voxels first" : "octree only") + " (per box)" + suffix, 20, n, [&]() {
+			long contacts = 0;
+			for (auto &b : landers) contacts += narrow.collide(b, manifold);
+			benchSink = benchSink + contacts;
+		});
+	}
+}
+
+//  the Williams ray/box slab test and box/box overlap on their own
+//
+static void benchBox() {
+	const int n = 4096;
+	Random rng(13);
+	vector<Box> boxes;
+	vector<Ray> rays;
+	for (int i = 0; i < n; i++) {
+		ofVec3f c = rng.inBox(ofVec3f(-10, -10, -10), ofVec3f(10, 10, 10));
+		ofVec3f s = rng.inBox(ofVec3f(0.5, 0.5, 0.5), ofVec3f(4, 4, 4));
+		boxes.push_back(Box(Vector3(c.x - s.x, c.y - s.y, c.z - s.z), Vector3(c.x + s.x, c.y + s.y, c.z + s.z)));
+		ofVec3f o = rng.onSphere() * 30;
+		ofVec3f d = (rng.inBox(ofVec3f(-5, -5, -5), ofVec3f(5, 5, 5)) - o).getNormalized();
+		rays.push_back(Ray(Vector3(o.x, o.y, o.z), Vector3(d.x, d.y, d.z)));
+	}
+	bench("Box::intersect ray", 200, n, [&]() {
+		long hits = 0;
+		for (int i = 0; i < n; i++) hits += boxes[i].intersect(rays[i], 0, 1000);
+		benchSink = benchSink + hits;
+	});
+	bench("Box::overlap", 200, n, [&]() {
+		long hits = 0;
+		for (int i = 0; i < n; i++) hits += boxes[i].overlap(boxes[(i * 7 + 1) % n]);
+		benchSink = benchSink + hits;
+	});
+}
+
+//  the point in box and box overlap kernels: converting each vertex to
+//  Vector3 and comparing component by component (the old octree code)
+//  against testing it in place with Vec4
+//
+static void benchVector() {
+	ofMesh terrain;
+	Terrain::heightfield(terrain);
+	int n = terrain.getNumVertices();
+	vector<int> points(n);
+	for (int i = 0; i < n; i++) points[i] = i;
+	Box box(Vector3(-50, -4, -50), Vector3(50, 4, 50));
+	vector<int> inside;
+	inside.reserve(n);
+
+	double scalar = bench("point in box, scalar", 50, n, [&]() {
+		inside.clear();
+		Vector3 lo = box.parameters[0], hi = box.parameters[1];
+		for (int i = 0; i < n; i++) {
+			ofVec3f v = terrain.getVertex(points[i]);
+			Vector3 p(v.x, v.y, v.z);
+			if (p.x() >= lo.x() && p.x() <= hi.x() && p.y() >= lo.y() && p.y() <= hi.y() &&
+				p.z() >= lo.z() && p.z() <= hi.z()) inside.push_back(points[i]);
+		}
+		benchSink = benchSink + inside.size();
+	});
+	double simd = bench("point in box, Vec4", 50, n, [&]() {
+		inside.clear();
+		const glm::vec3 *verts = terrain.getVerticesPointer();
+		Vec4 lo = Vec4::load3(box.parameters[0]), hi = Vec4::load3(box.parameters[1]);
+		for (int i = 0; i < n; i++) {
+			Vec4 v = Vec4::of(verts[points[i]]);
+			if (Vec4::allLessEqual3(lo, v) && Vec4::allLessEqual3(v, hi)) inside.push_back(points[i]);
+		}
+		benchSink = benchSink + inside.size();
+	});
+	cout << "point in box speedup: " << scalar / simd << "x" << endl;
+
+	const int m = 4096;
+	Random rng(19);
+	vector<Box> boxes;
+	for (int i = 0; i < m; i++) {
+		ofVec3f c = rng.inBox(ofVec3f(-10, -10, -10), ofVec3f(10, 10, 10));
+		boxes.push_back(Box(toVector3(c - ofVec3f(2, 2, 2)), toVector3(c + ofVec3f(2, 2, 2))));
+	}
+	scalar = bench("box overlap, scalar", 200, m, [&]() {
+		long hits = 0;
+		for (int i = 0; i < m; i++) {
+			const Box &a = boxes[i], &b = boxes[(i * 7 + 1) % m];
+			hits += b.parameters[0].x() <= a.parameters[1].x() && b.parameters[1].x() >= a.parameters[0].x() &&
+				b.parameters[0].y() <= a.parameters[1].y() && b.parameters[1].y() >= a.parameters[0].y() &&
+				b.parameters[0].z() <= a.parameters[1].z() && b.parameters[1].z() >= a.parameters[0].z();
+		}
+		benchSink = benchSink + hits;
+	});
+	simd = bench("box overlap, Vec4", 200, m, [&]() {
+		long hits = 0;
+		for (int i = 0; i < m; i++) hits += boxes[i].overlap(boxes[(i * 7 + 1) % m]);
+		benchSink = benchSink + hits;
+	});
+	cout << "box overlap speedup: " << scalar / simd << "x" << endl;
+}
+
+//  integrating particles under the forces the game uses
+//
+static void benchParticles() {
+	for (int n : { 1000, 10000 }) {
+		ParticleSystem sys;
+		GravityForce gravity(ofVec3f(0, -1.62, 0));
+		TurbulenceForce turbulence(ofVec3f(-1, -1, -1), ofVec3f(1, 1, 1));
+		sys.addForce(&gravity);
+		sys.addForce(&turbulence);
+		Particle *p = sys.append(n);
+		Random rng(17);
+		for (int i = 0; i < n; i++) {
+			p[i].position = rng.inBox(ofVec3f(-10, 0, -10), ofVec3f(10, 20, 10));
+			p[i].lifespan = -1;
+		}
+		SimClock clock;
+		bench("ParticleSystem::update (" + ofToString(n) + ")", 200, n, [&]() {
+			sys.update(clock);
+			clock.tick();
+		});
+	}
+}
+
+static void writeJson(const string &path, const string &tag, int levels) {
+	ofstream out(path);
+	out << "{\"tag\": \"" << tag << "\", \"levels\": " << levels << ", \"results\": [";
+	for (int i = 0; i < results.size(); i++) {
+		const BenchResult &r = results[i];
+		out << (i ? ",\n" : "\n") << "  {\"name\": \"" << r.name << "\", \"ns_per_item\": " << r.ns
+			<< ", \"reps\": " << r.reps << ", \"items\": " << r.items;
+		if (AllocCounter::enabled()) out << ", \"allocs_per_item\": " << r.allocs;
+		out << "}";
+	}
+	out << "\n], \"counters\": [";
+	for (int i = 0; i < counters.size(); i++) {
+		out << (i ? ",\n" : "\n") << "  {\"name\": \"" << counters[i].first << "\", \"value\": "
+			<< (long long)counters[i].second << "}";
+	}
+	out << "\n]}\n";
+	if (out.good()) cout << "results saved to " << path << endl;
+	else cout << "Can't write " << path << endl;
+}
+
+int main(int argc, char *argv[]) {
+	vector<int> sizes;
+	int levels = 20;
+	string only, jsonFile, tag;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool more = i + 1 < argc;
+		if (arg == "-res" && more) sizes.push_back(atoi(argv[++i]));
+		else if (arg == "-levels" && more) levels = atoi(argv[++i]);
+		else if (arg == "-only" && more) only = argv[++i];
+		else if (arg == "-json" && more) jsonFile = argv[++i];
+		else if (arg == "-tag" && more) tag = argv[++i];
+		else {
+			cout << "unknown option " << arg << endl;
+			return 1;
+		}
+	}
+	if (sizes.empty()) sizes = { 129, 257 };
+	for (int &res : sizes) res = MAX(res, 2);
+	vector<string> groups = ofSplitString(only, ",", true, true);
+	auto run = [&](const string &group) {
+		return groups.empty() || find(groups.begin(), groups.end(), group) != groups.end();
+	};
+
+	if (run("spawn")) benchSpawn();
+	if (run("staging")) benchStaging();
+	if (run("batch")) benchBatch();
+	if (run("box")) benchBox();
+	if (run("vector")) benchVector();
+	if (run("particles")) benchParticles();
+	if (run("template")) benchTemplate(levels);
+
+	if (run("octree") || run("compact") || run("order") || run("ropes") || run("coherent") || run("contacts") ||
+		run("lazy") || run("threads") || run("parallel") || run("voxels") || run("memory")) {
+		for (int res : sizes) {
+			string suffix = " [res " + ofToString(res) + "]";
+			ofMesh terrain;
+			Terrain::heightfield(terrain, 200, res);
+			if (run("octree")) benchOctree(terrain, levels, suffix);
+			if (run("compact")) benchCompact(terrain, levels, suffix);
+			if (run("order")) benchOrder(terrain, levels, suffix);
+			if (run("ropes")) benchRopes(terrain, levels, suffix);
+			if (run("lazy")) benchLazy(terrain, levels, suffix);
+			if (run("threads")) benchThreads(terrain, levels, suffix);
+			if (run("parallel")) benchParallel(terrain, levels, suffix);
+			if (run("voxels")) benchVoxels(terrain, levels, suffix);
+			if (run("memory")) benchMemory(terrain, levels, suffix);
+			if (run("contacts") || run("coherent")) {
+				Octree octree;
+				octree.create(terrain, levels);
+				if (run("contacts")) benchContacts(octree, suffix);
+				if (run("coherent")) benchCoherent(octree, suffix);
+			}
+		}
+	}
+
+	if (!jsonFile.empty()) writeJson(jsonFile, tag, levels);
+	return 0;
+}
@@ -0,0 +1,73 @@
+#--------------------------------------------------------------
+#
+#  Lunar Lander - step rate test
+#
+#  Flies the headless autopilot run at two physics rates and fails
+#  unless both end the same way: the same result, touchdown speeds
+#  within 0.1 m/s and fuel left within 2% of the full tank.
+#
+#    cmake -DHEADLESS=path/to/headless -P check_step_rate.cmake
+#
+
+if (NOT HEADLESS)
+	message(FATAL_ERROR "set HEADLESS to the headless tool")
+endif()
+if (NOT RATES)
+	set(RATES 60 240)
+endif()
+if (NOT FUEL)
+	set(FUEL 2500)
+endif()
+
+#  a decimal as an integer count of thousandths (math() is integer only)
+#
+function(to_milli value out)
+	if (value MATCHES "^(-?)([0-9]*)\\.?([0-9]*)")
+		set(frac "${CMAKE_MATCH_3}000")
+		string(SUBSTRING "${frac}" 0 3 frac)
+		set(whole "${CMAKE_MATCH_2}")
+		if (whole STREQUAL "")
+			set(whole 0)
+		endif()
+		math(EXPR milli "${CMAKE_MATCH_1}(${whole} * 1000 + 1${frac} - 1000)")
+	else()
+		set(milli 0)
+	endif()
+	set(${out} ${milli} PARENT_SCOPE)
+endfunction()
+
+set(first "")
+foreach (hz ${RATES})
+	execute_process(COMMAND ${HEADLESS} -noeffects -hz ${hz}
+		OUTPUT_VARIABLE out RESULT_VARIABLE status)
+	if (NOT status EQUAL 0)
+		message(FATAL_ERROR "headless -hz ${hz} failed (${status})")
+	endif()
+	if (NOT out MATCHES "result: ([a-z ]+), touchdown speed ([-0-9.]+), fuel left ([-0-9.]+)")
+		message(FATAL_ERROR "headless -hz ${hz}: no result line in\n${out}")
+	endif()
+	set(result "${CMAKE_MATCH_1}")
+	to_milli("${CMAKE_MATCH_2}" speed)
+	to_milli("${CMAKE_MATCH_3}" fuel)
+	message(STATUS "${hz} Hz: ${result}, touchdown speed ${CMAKE_MATCH_2}, fuel left ${CMAKE_MATCH_3}")
+
+	if (first STREQUAL "")
+		set(first ${hz})
+		set(result0 "${result}")
+		set(speed0 ${speed})
+		set(fuel0 ${fuel})
+		continue()
+	endif()
+	if (NOT result STREQUAL result0)
+		message(FATAL_ERROR "outcome depends on the step rate: ${result0} at ${first} Hz, ${result} at ${hz} Hz")
+	endif()
+	math(EXPR dspeed "${speed} - ${speed0}")
+	if (dspeed GREATER 100 OR dspeed LESS -100)
+		message(FATAL_ERROR "touchdown speed depends on the step rate")
+	endif()
+	math(EXPR dfuel "(${fuel} - ${fuel0}) * 50")
+	math(EXPR limit "${FUEL} * 1000")
+	if (dfuel GREATER limit OR dfuel LESS -${limit})
+		message(FATAL_ERROR "fuel use depends on the step rate")
+	endif()
+endforeach()
@@ -0,0 +1,187 @@
+//--------------------------------------------------------------
+//
+//  Lunar Lander - headless simulation
+//
+//  Runs the game simulation (LanderSim) with no window, GL context or
+//  frame clock, as fast as the CPU allows.  Built by tools/CMakeLists.txt
+//  against the simulation sources in src/ and openFrameworks core.
+//
+//  usage: headless [-terrain file.obj] [-lander file.obj] [-steps n]
+//                  [-hz rate] [-levels n] [-noeffects] [-record file]
+//                  [-profile [trace.json]] [-memory] [-queries]
+//                  [-nocoherence] [-lazy] [-novoxels]
+//
+//  Without -terrain a procedural heightfield is used.  The lander is
+//  flown by a simple autopilot that holds the descent rate.  -profile
+//  prints p50/p99 of the simulation's zones (see Profiler.h) and, given
+//  a file, saves them as a Chrome trace.  -memory prints the sizes of
+//  the octree, particle systems and collision tables at the end.
+//  -queries prints how often the collision and altitude queries were
+//  answered from last step's octree cell and the nodes they tested;
+//  -nocoherence starts every one of them at the root instead.  -lazy
+//  builds the octree on demand (Octree::bLazy).  -novoxels leaves out
+//  the voxel octree the collision broad phase tries first (VoxelOctree).
+//
+
+#include "ofMain.h"
+#include "LanderSim.h"
+#include "Terrain.h"
+#include "InputLog.h"
+#include "AllocCounter.h"
+
+int main(int argc, char *argv[]) {
+	string terrainFile, landerFile, recordFile, traceFile;
+	bool bProfile = false;
+	bool bMemory = false;
+	bool bQueries = false;
+	bool bCoherent = true;
+	bool bLazy = false;
+	bool bVoxels = true;
+	int maxSteps = 120 * 600;
+	float hz = 120;
+	int levels = 20;
+	LanderParams params;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool more = i + 1 < argc;
+		if (arg == "-terrain" && more) terrainFile = argv[++i];
+		else if (arg == "-lander" && more) landerFile = argv[++i];
+		else if (arg == "-steps" && more) maxSteps = atoi(argv[++i]);
+		else if (arg == "-hz" && more) hz = atof(argv[++i]);
+		else if (arg == "-levels" && more) levels = atoi(argv[++i]);
+		else if (arg == "-noeffects") params.bEffects = false;
+		else if (arg == "-record" && more) recordFile = argv[++i];
+		else if (arg == "-memory") bMemory = true;
+		else if (arg == "-queries") bQueries = true;
+		else if (arg == "-nocoherence") bCoherent = false;
+		else if (arg == "-lazy") bLazy = true;
+		else if (arg == "-novoxels") bVoxels = false;
+		else if (arg == "-profile") {
+			bProfile = true;
+			if (more && argv[i + 1][0] != '-') traceFile = argv[++i];
+		}
+		else {
+			cout << "unknown option " << arg << endl;
+			return 1;
+		}
+	}
+
+	// terrain and octree
+	//
+	ofMesh terrain;
+	if (terrainFile.empty()) Terrain::heightfield(terrain);
+	else if (!Terrain::loadObj(terrainFile, terrain)) {
+		cout << "Can't load terrain " << terrainFile << endl;
+		return 1;
+	}
+
+	Profiler::enable(bProfile);
+	Profiler::setThreadName("main");
+
+	auto t0 = chrono::steady_clock::now();
+	Octree octree;
+	octree.bLazy = bLazy;
+	octree.create(terrain, levels);
+	auto tv = chrono::steady_clock::now();
+	VoxelOctree voxels;
+	if (bVoxels) voxels.build(terrain);
+	auto t1 = chrono::steady_clock::now();
+
+	// lander bounds, a 2 x 2 x 2 box sitting on its origin by default
+	//
+	Box landerBounds(Vector3(-1, 0, -1), Vector3(1, 2, 1));
+	if (!landerFile.empty()) {
+		ofMesh landerMesh;
+		if (!Terrain::loadObj(landerFile, landerMesh)) {
+			cout << "Can't load lander " << landerFile << endl;
+			return 1;
+		}
+		landerBounds = Octree::meshBounds(landerMesh);
+	}
+
+	LanderSim sim;
+	sim.setup(&octree, params);
+	sim.clock.setStep(1.0 / hz);
+	sim.setLanderBounds(landerBounds);
+	sim.spawn(ofVec3f(0, 50, 0));
+	sim.narrowPhase.query.bEnabled = bCoherent;
+	sim.altitudeQuery.bEnabled = bCoherent;
+	if (bVoxels) sim.narrowPhase.voxels = &voxels;
+
+	// all inputs go through the log, it ignores them unless recording
+	//
+	InputLog log;
+	if (!recordFile.empty()) log.begin(sim);
+	auto press = [&](int key, bool down) {
+		log.record(sim.clock.ticks, key, down);
+		if (down) sim.keyPressed(key);
+		else sim.keyReleased(key);
+	};
+	press(' ', true);
+
+	// fly: thrust up whenever falling faster than 1 m/s
+	//
+	const float maxDescent = 1.0;
+	bool bUp = false;
+	int steps = 0;
+	AllocCounter::Snapshot a1 = AllocCounter::snapshot();
+	while (sim.bGame && steps < maxSteps) {
+		float vy = sim.sys.particles.size() > 0 ? sim.sys.particles[0].velocity.y : 0;
+		bool want = vy < -maxDescent && sim.fuel > 0;
+		if (want != bUp) {
+			press('z', want);
+			bUp = want;
+		}
+		sim.step();
+		sim.calculateAltitude();
+		steps++;
+	}
+	auto t2 = chrono::steady_clock::now();
+	AllocCounter::Snapshot a2 = AllocCounter::snapshot();
+
+	if (log.bRecording) {
+		log.end(sim);
+		if (!log.save(recordFile)) cout << "Can't write " << recordFile << endl;
+		else cout << "recorded " << log.events.size() << " inputs to " << recordFile << endl;
+	}
+
+	double buildMs = chrono::duration<double, milli>(tv - t0).count();
+	double voxelMs = chrono::duration<double, milli>(t1 - tv).count();
+	double runMs = chrono::duration<double, milli>(t2 - t1).count();
+	double simSec = sim.clock.now();
+
+	cout << "terrain: " << terrain.getNumVertices() << " vertices, octree "
+		<< levels << " levels, built in " << buildMs << " ms" << endl;
+	if (bVoxels) {
+		cout << "voxels: " << voxels.side() << "^3, " << voxels.nodes.size() << " nodes, "
+			<< voxels.bricks.size() << " bricks, " << voxels.bytes() << " bytes, built in " << voxelMs << " ms" << endl;
+	}
+	cout << "steps: " << steps << " (" << simSec << " s simulated at " << hz << " Hz)" << endl;
+	cout << "wall: " << runMs << " ms, " << (runMs > 0 ? simSec * 1000 / runMs : 0)
+		<< "x real time, " << (steps > 0 ? runMs * 1000 / steps : 0) << " us/step" << endl;
+
+	string result;
+	if (sim.bGame) result = "still flying";
+	else if (!sim.bLife) result = "crashed";
+	else if (sim.bInside) result = "landed inside";
+	else result = "landed outside";
+	cout << "result: " << result << ", touchdown speed " << sim.collisionVel
+		<< ", fuel left " << sim.fuel << endl;
+	if (AllocCounter::enabled()) {
+		cout << "allocations: " << (steps > 0 ? (double)(a2 - a1).allocations / steps : 0) << " per step" << endl;
+	}
+	if (bMemory) sim.printMemory(cout);
+	if (bQueries) sim.printQueries(cout);
+
+	if (bProfile) {
+		cout << endl;
+		Profiler::print(cout);
+		if (!traceFile.empty()) {
+			if (Profiler::writeTrace(traceFile)) cout << "trace saved to " << traceFile << endl;
+			else cout << "Can't write " << traceFile << endl;
+		}
+	}
+
+	return sim.bGame ? 2 : 0;
+}
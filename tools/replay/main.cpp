@@ -0,0 +1,91 @@
+//--------------------------------------------------------------
+//
+//  Lunar Lander - input replay
+//
+//  Replays a recorded input log (InputLog, written by the game as
+//  last-run.inputs or by headless -record) with no window, as fast as
+//  the CPU allows, and checks that the run ends in exactly the recorded
+//  state.  Exits non-zero if it doesn't, so recorded sessions work as
+//  regression tests and, with -repeat, as benchmarks of the physics and
+//  collision paths.  Built by tools/CMakeLists.txt against the
+//  simulation sources in src/ and openFrameworks core.
+//
+//  usage: replay file.inputs [-terrain file.obj] [-levels n] [-repeat n]
+//
+//  The terrain must be the one the log was recorded on (the procedural
+//  heightfield if -terrain isn't given).
+//
+
+#include "ofMain.h"
+#include "InputLog.h"
+#include "Terrain.h"
+
+int main(int argc, char *argv[]) {
+	string logFile, terrainFile;
+	int levels = 20;
+	int repeat = 1;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool more = i + 1 < argc;
+		if (arg == "-terrain" && more) terrainFile = argv[++i];
+		else if (arg == "-levels" && more) levels = atoi(argv[++i]);
+		else if (arg == "-repeat" && more) repeat = atoi(argv[++i]);
+		else if (logFile.empty() && arg[0] != '-') logFile = arg;
+		else {
+			cout << "unknown option " << arg << endl;
+			return 1;
+		}
+	}
+	repeat = MAX(repeat, 1);
+	if (logFile.empty()) {
+		cout << "usage: replay file.inputs [-terrain file.obj] [-levels n] [-repeat n]" << endl;
+		return 1;
+	}
+
+	InputLog log;
+	if (!log.load(logFile)) {
+		cout << "Can't load input log " << logFile << endl;
+		return 1;
+	}
+
+	ofMesh terrain;
+	if (terrainFile.empty()) Terrain::heightfield(terrain);
+	else if (!Terrain::loadObj(terrainFile, terrain)) {
+		cout << "Can't load terrain " << terrainFile << endl;
+		return 1;
+	}
+	if (InputLog::meshHash(terrain) != log.terrainHash) {
+		cout << "warning: terrain differs from the one this log was recorded on" << endl;
+	}
+	Octree octree;
+	octree.create(terrain, levels);
+
+	bool bMatch = true;
+	long totalSteps = 0;
+	auto t1 = chrono::steady_clock::now();
+	for (int r = 0; r < repeat; r++) {
+		LanderSim sim;
+		sim.setup(&octree, log.params);
+		totalSteps += log.replay(sim);
+		bMatch = bMatch && log.matches(sim);
+
+		if (r == 0) {
+			string result;
+			if (sim.bGame) result = "still flying";
+			else if (!sim.bLife) result = "crashed";
+			else if (sim.bInside) result = "landed inside";
+			else result = "landed outside";
+			cout << log.events.size() << " inputs, " << log.endTick - log.startTick << " steps ("
+				<< (log.endTick - log.startTick) * log.step << " s): " << result
+				<< ", fuel left " << sim.fuel << endl;
+		}
+	}
+	auto t2 = chrono::steady_clock::now();
+	double ms = chrono::duration<double, milli>(t2 - t1).count();
+
+	cout << "replayed " << repeat << "x in " << ms << " ms, "
+		<< (totalSteps > 0 ? ms * 1000 / totalSteps : 0) << " us/step" << endl;
+	cout << (bMatch ? "end state matches the recording" : "END STATE DIFFERS from the recording") << endl;
+	return bMatch ? 0 : 1;
+}